@@ -2,18 +2,25 @@
 #define AVLTREE_H
 
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <map>
 #include <set>
 #include <string>
+#include <string_view>
 #include "document.h"
+#include "NodeAllocator.h"
 
 using namespace std;
 
-template <typename Key, typename Value>
+// NodeAllocator is the allocation policy for the tree nodes, see NodeAllocator.h
+template <typename Key, typename Value, template <typename> class NodeAllocator = SlabAllocator>
 class AvlTree
 {
 private:
@@ -25,43 +32,129 @@ private:
         AvlNode *left;  // pointer to the left child
         AvlNode *right; // pointer to the right child
         int height;     // height of the node in the AVL tree
+        int count;      // number of nodes in the subtree rooted at the node
 
         // constructors for creating nodes
-        AvlNode(const Key &k, const Value &v, AvlNode *lt, AvlNode *rt, int h = 0)
-            : k{k}, v{v}, left{lt}, right{rt}, height{h} {}
+        AvlNode(const Key &k, const Value &v, AvlNode *lt, AvlNode *rt, int h = 0, int c = 1)
+            : k{k}, v{v}, left{lt}, right{rt}, height{h}, count{c} {}
 
-        AvlNode(const Key &k, AvlNode *lt, AvlNode *rt, int h = 0)
-            : k{k}, left{lt}, right{rt}, height{h} {}
+        // builds a leaf with the key from k and the value from args in place
+        template <typename K, typename... Args>
+        AvlNode(std::piecewise_construct_t, K &&k, Args &&...args)
+            : k(std::forward<K>(k)), v(std::forward<Args>(args)...), left{nullptr}, right{nullptr}, height{0}, count{1} {}
     };
 
     AvlNode *root; // pointer to the top of the node
 
-    // Function to insert a new node into the AVL tree
-    void insert(const Key &x, const Value &value, AvlNode *&t)
+    NodeAllocator<AvlNode> nodes; // allocator that owns the memory of every node
+
+    // Longest root to leaf path the tree supports. An AVL tree of height h holds at least
+    // Fibonacci(h + 3) - 1 nodes, so 64 levels are more than memory can ever hold.
+    static const int MAX_HEIGHT = 64;
+
+    // Links to the nodes on the way down from the root, deepest last. Nodes do not point to their
+    // parents, so insertions record the path they took here to rebalance on the way back up.
+    struct Path
     {
-        if (t == nullptr)
+        AvlNode **links[MAX_HEIGHT];
+        int depth = 0;
+    };
+
+    // Walks down from the root towards x, recording the link to every node passed in path. Returns
+    // the link that holds x, or the empty link where x belongs.
+    template <typename K>
+    AvlNode *&descend(const K &x, Path &path)
+    {
+        AvlNode **link = &root;
+        while (*link != nullptr)
         {
-            t = new AvlNode(x, value, nullptr, nullptr);
-            return;
+            AvlNode *t = *link;
+            if (x < t->k)
+            {
+                path.links[path.depth++] = link;
+                link = &t->left;
+            }
+            else if (t->k < x)
+            {
+                path.links[path.depth++] = link;
+                link = &t->right;
+            }
+            else
+                break;
         }
+        return *link;
+    }
 
-        if (x < t->k)
+    // Rebalances the nodes on path from the deepest one up after a node was added below them. Once a
+    // subtree keeps its height, nothing above it needs rotating and only the counts go up.
+    void rebalance(Path &path)
+    {
+        while (path.depth > 0)
         {
-            insert(x, value, t->left);
+            AvlNode *&t = *path.links[--path.depth];
+            int before = t->height;
+            balance(t);
+            if (t->height == before)
+                break;
         }
-        else if (t->k < x)
+        while (path.depth > 0)
+            (*path.links[--path.depth])->count++;
+    }
+
+    // Returns the node holding x, or nullptr. x can be of any type that compares with Key.
+    template <typename K>
+    AvlNode *findNode(const K &x) const
+    {
+        AvlNode *t = root;
+        while (t != nullptr)
         {
-            insert(x, value, t->right);
+            if (x < t->k)
+                t = t->left;
+            else if (t->k < x)
+                t = t->right;
+            else
+                return t;
         }
-        else
+        return nullptr;
+    }
+
+    // Calls visit(node) for every node of the tree in ascending key order
+    template <typename Visitor>
+    void inOrder(Visitor &&visit) const
+    {
+        AvlNode *stack[MAX_HEIGHT];
+        int depth = 0;
+        AvlNode *t = root;
+        while (t != nullptr || depth > 0)
         {
-            // Update the value for the duplicate key
-            t->v = value; // Or merge the existing value with the new value, depending on your requirements
+            for (; t != nullptr; t = t->left)
+                stack[depth++] = t;
+            t = stack[--depth];
+            visit(t);
+            t = t->right;
         }
+    }
+
+    // Builds a perfectly balanced subtree of the n entries starting at first, which are in ascending
+    // key order. The recursion halves n, so it never goes deeper than the tree it builds.
+    template <typename Iterator>
+    AvlNode *build(Iterator first, size_t n)
+    {
+        if (n == 0)
+            return nullptr;
 
-        // Balance the tree after inserting a new node
-        balance(t);
+        size_t middle = n / 2;
+        AvlNode *left = build(first, middle);
+        auto &&entry = *(first + middle);
+        AvlNode *t = nodes.create(std::piecewise_construct, std::forward<decltype(entry)>(entry).first,
+                                  std::forward<decltype(entry)>(entry).second);
+        t->left = left;
+        t->right = build(first + middle + 1, n - middle - 1);
+        t->height = max(height(t->left), height(t->right)) + 1;
+        t->count = static_cast<int>(n);
+        return t;
     }
+
     // Public method definitions
 public:
     // Constructor
@@ -79,11 +172,207 @@ public:
     // Inserts a key-value pair into the tree
     void insert(const Key &key, const Value &value)
     {
-        insert(key, value, root);
+        Path path;
+        AvlNode *&t = descend(key, path);
+        if (t != nullptr)
+        {
+            t->v = value; // Update the value for the duplicate key
+            return;
+        }
+        t = nodes.create(key, value, nullptr, nullptr);
+        rebalance(path);
+    }
+
+    // Inserts a key-value pair into the tree, moving both into the node
+    void insert(Key &&key, Value &&value)
+    {
+        Path path;
+        AvlNode *&t = descend(key, path);
+        if (t != nullptr)
+        {
+            t->v = std::move(value); // Update the value for the duplicate key
+            return;
+        }
+        t = nodes.create(std::piecewise_construct, std::move(key), std::move(value));
+        rebalance(path);
+    }
+
+    // Adds the key with a value built in place from args unless the key is already present. Returns
+    // the value of the key either way.
+    template <typename... Args>
+    Value &emplace(const Key &key, Args &&...args)
+    {
+        Path path;
+        AvlNode *&t = descend(key, path);
+        if (t != nullptr)
+            return t->v;
+
+        AvlNode *created = nodes.create(std::piecewise_construct, key, std::forward<Args>(args)...);
+        t = created;
+        rebalance(path); // Rotations relink nodes but never move them, so created stays valid
+        return created->v;
+    }
+
+    // Gets the value of a key, or nullptr when it is not present. The key can be of any type that
+    // compares with Key, such as a std::string_view for std::string keys.
+    template <typename K>
+    Value *find(const K &key)
+    {
+        AvlNode *t = findNode(key);
+        return t == nullptr ? nullptr : &t->v;
+    }
+
+    template <typename K>
+    const Value *find(const K &key) const
+    {
+        AvlNode *t = findNode(key);
+        return t == nullptr ? nullptr : &t->v;
+    }
+
+    // Replaces the contents of the tree by the (key, value) pairs of [first, last), which must be in
+    // strictly ascending key order, throws std::invalid_argument when they are not. Builds a perfectly
+    // balanced tree in O(n) without a single comparison on the way down or rotation on the way up.
+    // The pairs are copied, pass std::move_iterators to move them in instead.
+    template <typename RandomAccessIterator>
+    void buildFromSorted(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        for (RandomAccessIterator it = first; it != last && it + 1 != last; ++it)
+        {
+            if (!((*it).first < (*(it + 1)).first))
+                throw std::invalid_argument("Keys passed to buildFromSorted are not in ascending order.");
+        }
+        makeEmpty();
+        root = build(first, static_cast<size_t>(last - first));
+    }
+
+    // Calls visit(key, value) for every entry in ascending key order
+    template <typename Visitor>
+    void forEach(Visitor visit)
+    {
+        inOrder([&visit](AvlNode *t) { visit(t->k, t->v); });
+    }
+
+    // Forward iterator over the entries in ascending key order. Nodes do not point to their parents,
+    // so the iterator keeps the nodes it still has to come back to on a stack, like inOrder() does.
+    // Dereferencing gives a pair of references to the key and the value of the entry.
+    template <bool IsConst>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const Key, Value>;
+        using reference = std::pair<const Key &, std::conditional_t<IsConst, const Value &, Value &>>;
+
+        // Holds the pair of references so that it->first and it->second work
+        struct pointer
+        {
+            reference entry;
+            const reference *operator->() const { return &entry; }
+        };
+
+        Iterator() = default;
+
+        // An iterator converts to a const_iterator
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        Iterator(const Iterator<OtherConst> &other) : depth(other.depth)
+        {
+            std::copy(other.stack, other.stack + other.depth, stack);
+        }
+
+        reference operator*() const
+        {
+            AvlNode *t = stack[depth - 1];
+            return reference(t->k, t->v);
+        }
+
+        pointer operator->() const
+        {
+            return pointer{**this};
+        }
+
+        // Moves to the leftmost node of the right subtree, or back up to the closest pending node
+        Iterator &operator++()
+        {
+            AvlNode *t = stack[--depth]->right;
+            for (; t != nullptr; t = t->left)
+                stack[depth++] = t;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            if (depth == 0 || other.depth == 0)
+                return depth == other.depth;
+            return stack[depth - 1] == other.stack[other.depth - 1];
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class AvlTree;
+        template <bool>
+        friend class Iterator;
+
+        AvlNode *stack[MAX_HEIGHT]; // current node on top, below it the nodes left to come back to
+        int depth = 0;              // 0 past the last entry
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // Pair of iterators that range-based for loops can walk
+    template <typename It>
+    struct Range
+    {
+        It first, last;
+        It begin() const { return first; }
+        It end() const { return last; }
+    };
+
+    iterator begin() { return leftmost<iterator>(); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return leftmost<const_iterator>(); }
+    const_iterator end() const { return const_iterator(); }
+
+    // Iterator to the first entry whose key is not less than key, the key can be of any type that
+    // compares with Key
+    template <typename K>
+    iterator lower_bound(const K &key) { return bound<iterator>(key, false); }
+    template <typename K>
+    const_iterator lower_bound(const K &key) const { return bound<const_iterator>(key, false); }
+
+    // Iterator to the first entry whose key is greater than key
+    template <typename K>
+    iterator upper_bound(const K &key) { return bound<iterator>(key, true); }
+    template <typename K>
+    const_iterator upper_bound(const K &key) const { return bound<const_iterator>(key, true); }
+
+    // Entries whose key starts with prefix, for string keys. All of them sit next to each other in key
+    // order, so this is one descent to each end of the range.
+    Range<iterator> prefix_range(std::string_view prefix)
+    {
+        return {lower_bound(prefix), prefixEnd<iterator>(prefix)};
+    }
+
+    Range<const_iterator> prefix_range(std::string_view prefix) const
+    {
+        return {lower_bound(prefix), prefixEnd<const_iterator>(prefix)};
     }
 
-    // Checks if a key is present in the tree
-    bool contains(const Key &k) const;
+    // Checks if a key is present in the tree, the key can be of any type that compares with Key
+    template <typename K>
+    bool contains(const K &k) const;
 
     // Checks if the tree is empty
     bool isEmpty() const;
@@ -100,8 +389,9 @@ public:
     // Removes a key from the tree
     void remove(const Key &k);
 
-    // Gets the values associated with the given key
-    Value &getValues(Key K);
+    // Gets the values associated with the given key, throws std::runtime_error when it is not present
+    template <typename K>
+    Value &getValues(const K &key);
 
     // Overloaded subscript operator to get the values associated with the given key
     Value &operator[](const Key &K);
@@ -109,17 +399,18 @@ public:
     // Checks the balance of the tree
     void check_balance() const;
 
-    // Gets all the keys in the tree
-    vector<Key> getKeys();
-
-    // Helper function for getKeys()
-    void getKeys(vector<Key> &keys, AvlNode *node, int level);
+    // Gets all the keys in the tree in level order
+    vector<Key> getKeys() const;
 
     // Get the size of the tree
-    int size();
+    int size() const;
+
+    // Gets the number of keys in the tree that are less than the given key, which is the position the
+    // key has or would have in ascending order
+    int rank(const Key &K) const;
 
-    // Helper function for size()
-    int size(AvlNode *node);
+    // Gets the key at position i in ascending order, throws std::out_of_range unless 0 <= i < size()
+    const Key &select(int i) const;
 
     // Writes the contents of the tree to a file
     void writeIndex(string &, AvlTree<string, map<string, int>> &);
@@ -128,24 +419,12 @@ public:
 
     // Private method definitions
 private:
-    // Root node of the tree
-    AvlNode *root;
-
-    // Get the size of the tree
-    int size(AvlNode *node) const;
+    // Maximum height difference allowed between the two subtrees of a node
+    static const int ALLOWED_IMBALANCE = 1;
 
     // Check the balance of the tree
     int check_balance(AvlNode *node) const;
 
-    // Get the values associated with the given key
-    Value &getValues(Key K, AvlNode *t);
-
-    // Overloaded subscript operator helper function
-    Value &bracketHelper(Key x, AvlNode *&t);
-
-    // Inserts a key-value pair into the tree
-    void insert(const Key &x, AvlNode *&t);
-
     // Removes a key from the tree
     void remove(const Key &x, AvlNode *&t);
 
@@ -155,14 +434,11 @@ private:
     // Finds the minimum node in the tree
     AvlNode *findMin(AvlNode *t) const;
 
-    // Checks if a key is present in the tree
-    bool contains(const Key &x, AvlNode *t) const;
-
     // Empties the tree
     void makeEmpty(AvlNode *&t);
 
     // Clones a tree
-    AvlNode *clone(AvlNode *t) const;
+    AvlNode *clone(AvlNode *t);
 
     // Pretty prints the tree
     void prettyPrintTree(const string &prefix, const AvlNode *node, bool isRight) const;
@@ -170,6 +446,9 @@ private:
     // Get the height of the tree
     int height(AvlNode *t) const;
 
+    // Get the number of nodes in the tree
+    int count(AvlNode *t) const;
+
     // Balance the tree
     void balance(AvlNode *&t);
 
@@ -188,31 +467,74 @@ private:
     // Double rotates the tree right
     void doubleRight(AvlNode *&k1);
 
-    // Helper function for getKeys()
-    void getKeys(vector<Key> &keys, AvlNode *node, int level) const;
+    // Iterator to the smallest entry
+    template <typename It>
+    It leftmost() const
+    {
+        It it;
+        for (AvlNode *t = root; t != nullptr; t = t->left)
+            it.stack[it.depth++] = t;
+        return it;
+    }
+
+    // Iterator to the first entry whose key is not less than key, or greater than key when upper is
+    // true. The descent keeps every node where it turns left, which is exactly the stack an iterator
+    // would have on reaching that entry from begin().
+    template <typename It, typename K>
+    It bound(const K &key, bool upper) const
+    {
+        It it;
+        AvlNode *t = root;
+        while (t != nullptr)
+        {
+            if (upper ? key < t->k : !(t->k < key))
+            {
+                it.stack[it.depth++] = t;
+                t = t->left;
+            }
+            else
+                t = t->right;
+        }
+        return it;
+    }
+
+    // Iterator past the last key starting with prefix: the lower bound of the smallest string greater
+    // than every such key, which is the prefix without trailing 0xFF bytes and its last byte plus one
+    template <typename It>
+    It prefixEnd(std::string_view prefix) const
+    {
+        std::string limit(prefix);
+        while (!limit.empty() && static_cast<unsigned char>(limit.back()) == 0xFF)
+            limit.pop_back();
+        if (limit.empty())
+            return It();
+        limit.back() = static_cast<char>(static_cast<unsigned char>(limit.back()) + 1);
+        return bound<It>(limit, false);
+    }
 
     // Helper function for writeIndex()
-    void writeIndex(ostream &file, AvlTree<string, map<string, int>> &tree, AvlNode *t);
-    void writeIndex(ostream &file, AvlTree<string, set<string>> &tree, AvlNode *t);
-    void writeIndex(ostream &file, AvlTree<string, document> &tree, AvlNode *t);
+    void writeIndex(ostream &file, AvlTree<string, map<string, int>> &tree);
+    void writeIndex(ostream &file, AvlTree<string, set<string>> &tree);
+    void writeIndex(ostream &file, AvlTree<string, document> &tree);
+};
 
     // Copy Constructor
-    template <typename Key, typename Value>
-    AvlTree<Key, Value>::AvlTree(const AvlTree &rhs) : root(nullptr)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    AvlTree<Key, Value, NodeAllocator>::AvlTree(const AvlTree &rhs) : root(nullptr)
     {
         *this = rhs;
     }
 
     // Destructor
-    template <typename Key, typename Value>
-    AvlTree<Key, Value>::~AvlTree()
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    AvlTree<Key, Value, NodeAllocator>::~AvlTree()
     {
         makeEmpty();
     }
 
     // Assignment operator
-    template <typename Key, typename Value>
-    AvlTree<Key, Value> &AvlTree<Key, Value>::operator=(const AvlTree &rhs)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    AvlTree<Key, Value, NodeAllocator> &AvlTree<Key, Value, NodeAllocator>::operator=(const AvlTree &rhs)
     {
         if (this != &rhs)
         {
@@ -225,22 +547,23 @@ private:
     // Accessor methods
 
     // Returns true if the tree contains the given key
-    template <typename Key, typename Value>
-    bool AvlTree<Key, Value>::contains(const Key &k) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    template <typename K>
+    bool AvlTree<Key, Value, NodeAllocator>::contains(const K &k) const
     {
-        return contains(k, root);
+        return findNode(k) != nullptr;
     }
 
     // Returns true if the tree is empty
-    template <typename Key, typename Value>
-    bool AvlTree<Key, Value>::isEmpty() const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    bool AvlTree<Key, Value, NodeAllocator>::isEmpty() const
     {
         return root == nullptr;
     }
 
     // Prints the keys in the tree in ascending order
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::printTree() const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::printTree() const
     {
         if (isEmpty())
         {
@@ -253,8 +576,8 @@ private:
     }
 
     // Prints the keys and structure of the tree in a pretty format
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::prettyPrintTree() const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::prettyPrintTree() const
     {
         if (isEmpty())
         {
@@ -269,24 +592,28 @@ private:
     // Modifier methods (Implementation for methods like insert, remove, makeEmpty, etc.)
 
     // Makes the tree empty
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::makeEmpty()
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::makeEmpty()
     {
-        makeEmpty(root);
+        // Nodes only have to be visited one by one when they need destructing or freeing individually
+        if (!NodeAllocator<AvlNode>::releasesInBulk || !std::is_trivially_destructible<AvlNode>::value)
+            makeEmpty(root);
+        nodes.clear(); // Release the node memory
+        root = nullptr;
     }
 
     // Inserts a key into the tree
 
     // Removes a key from the tree
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::remove(const Key &k)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::remove(const Key &k)
     {
         remove(k, root);
     }
 
     // Writes an index to a file based on the type of the AVL Tree
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(string &filename, AvlTree<string, map<string, int>> &index)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(string &filename, AvlTree<string, map<string, int>> &index)
     {
         ofstream file(filename); // Open a file with the given filename
         if (!file.is_open())
@@ -294,12 +621,12 @@ private:
             cerr << "Error opening file" << endl; // If not, display an error message
             exit(1);                              // Exit the program
         }
-        writeIndex(file, index, root); // Write the index to the file
+        writeIndex(file, index);       // Write the index to the file
         file.close();                  // Close the file
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(string &filename, AvlTree<string, set<string>> &index)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(string &filename, AvlTree<string, set<string>> &index)
     {
         ofstream file(filename); // Open a file with the given filename
         if (file.is_open() == false)
@@ -307,12 +634,12 @@ private:
             cerr << "Error opening file" << endl; // If not, display an error message
             exit(1);                              // Exit the program
         }
-        writeIndex(filename, index); // Write the index to the file
-        file.close();                // Close the file
+        writeIndex(file, index);       // Write the index to the file
+        file.close();                  // Close the file
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(string &filename, AvlTree<string, document> &index)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(string &filename, AvlTree<string, document> &index)
     {
         ofstream file(filename); // Open a file with the given filename
         if (file.is_open() == false)
@@ -320,53 +647,57 @@ private:
             cerr << "Error opening file" << endl; // If not, display an error message
             exit(1);                              // Exit the program
         }
-        writeIndex(filename, index); // Write the index to the file
-        file.close();                // Close the file
+        writeIndex(file, index);       // Write the index to the file
+        file.close();                  // Close the file
     }
 
     // rotateLeft() performs a left rotation on the tree, swapping two nodes and updating their heights.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::rotateLeft(AvlNode *&k1)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::rotateLeft(AvlNode *&k1)
     {
         AvlNode *k2 = k1->right;
         k1->right = k2->left;
         k2->left = k1;
         k1->height = max(height(k1->left), height(k1->right)) + 1;
         k2->height = max(height(k2->right), k1->height) + 1;
+        k2->count = k1->count;
+        k1->count = count(k1->left) + count(k1->right) + 1;
         k1 = k2;
     }
 
     // rotateRight() performs a right rotation on the tree, swapping two nodes and updating their heights.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::rotateRight(AvlNode *&k2)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::rotateRight(AvlNode *&k2)
     {
         AvlNode *k1 = k2->left;
         k2->left = k1->right;
         k1->right = k2;
         k2->height = max(height(k2->left), height(k2->right)) + 1;
         k1->height = max(height(k1->left), k2->height) + 1;
+        k1->count = k2->count;
+        k2->count = count(k2->left) + count(k2->right) + 1;
         k2 = k1;
     }
 
     // doubleLeft() performs a double left rotation on the tree, swapping three nodes and updating their heights.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::doubleLeft(AvlNode *&k3)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::doubleLeft(AvlNode *&k3)
     {
-        rotateRight(k3->left);
+        rotateRight(k3->right);
         rotateLeft(k3);
     }
 
     // doubleRight() performs a double right rotation on the tree, swapping three nodes and updating their heights.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::doubleRight(AvlNode *&k1)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::doubleRight(AvlNode *&k1)
     {
-        rotateLeft(k1->right);
+        rotateLeft(k1->left);
         rotateRight(k1);
     }
 
     // balance() balances the tree by checking the difference in heights of each node's left and right subtrees.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::balance(AvlNode *&t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::balance(AvlNode *&t)
     {
         if (t == nullptr)
             return;
@@ -387,11 +718,12 @@ private:
         }
 
         t->height = max(height(t->left), height(t->right)) + 1;
+        t->count = count(t->left) + count(t->right) + 1;
     }
 
     // findMin() finds the minimum value in the tree.
-    template <typename Key, typename Value>
-    typename AvlTree<Key, Value>::AvlNode *AvlTree<Key, Value>::findMin(AvlTree<Key, Value>::AvlNode *t) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    typename AvlTree<Key, Value, NodeAllocator>::AvlNode *AvlTree<Key, Value, NodeAllocator>::findMin(AvlTree<Key, Value, NodeAllocator>::AvlNode *t) const
     {
         if (t == nullptr)
             return nullptr;
@@ -403,8 +735,8 @@ private:
     }
 
     // remove() removes a node from the tree and balances the tree afterwards.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::remove(const Key &x, AvlNode *&t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::remove(const Key &x, AvlNode *&t)
     {
         if (t == nullptr)
             throw std::runtime_error("Key not found"); // Throw exception if item not found
@@ -428,7 +760,7 @@ private:
                     replacement->right = t->right;
                 }
 
-                delete t;
+                nodes.destroy(t);
                 t = replacement;
             }
             else
@@ -436,7 +768,7 @@ private:
                 AvlNode *oldNode = t;
                 t = (t->left != nullptr) ? t->left : t->right;
 
-                delete oldNode;
+                nodes.destroy(oldNode);
             }
         }
 
@@ -447,8 +779,8 @@ private:
     }
 
     // removeMin() removes the minimum value from the tree and returns it.
-    template <class Key, class Value>
-    typename AvlTree<Key, Value>::AvlNode *AvlTree<Key, Value>::removeMin(AvlTree<Key, Value>::AvlNode *&t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    typename AvlTree<Key, Value, NodeAllocator>::AvlNode *AvlTree<Key, Value, NodeAllocator>::removeMin(AvlTree<Key, Value, NodeAllocator>::AvlNode *&t)
     {
         if (t == nullptr)
         {
@@ -468,42 +800,32 @@ private:
         return findMin;
     }
 
-    template <typename Key, typename Value>
-    bool AvlTree<Key, Value>::contains(const Key &x, AvlNode *t) const
-    {
-        if (t == nullptr) // Return false if node is null
-            return false;
-        else if (x < t->k) // If x is less than key of node, search left subtree
-            return contains(x, t->left);
-        else if (t->k < x) // If x is greater than key of node, search right subtree
-            return contains(x, t->right);
-        else // Match found
-            return true;
-    }
-
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::makeEmpty(AvlNode *&t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::makeEmpty(AvlNode *&t)
     {
         if (t == nullptr) // Return if node is null
             return;
 
         makeEmpty(t->left);  // Recursively delete nodes from left subtree
         makeEmpty(t->right); // Recursively delete nodes from right subtree
-        delete t;            // Delete node
+        if (NodeAllocator<AvlNode>::releasesInBulk)
+            t->~AvlNode();   // Memory goes back with the whole arena in makeEmpty()
+        else
+            nodes.destroy(t); // Delete node
         t = nullptr;         // Set node to null
     }
 
-    template <typename Key, typename Value>
-    typename AvlTree<Key, Value>::AvlNode *AvlTree<Key, Value>::clone(AvlNode *t) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    typename AvlTree<Key, Value, NodeAllocator>::AvlNode *AvlTree<Key, Value, NodeAllocator>::clone(AvlNode *t)
     {
         if (t == nullptr) // Return null if node is null
             return nullptr;
 
-        return new AvlNode{t->k, t->v, clone(t->left), clone(t->right), t->height}; // Create a new node with same key, value, left subtree, right subtree and height
+        return nodes.create(t->k, t->v, clone(t->left), clone(t->right), t->height, t->count); // Create a new node with same key, value, left subtree, right subtree, height and count
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::prettyPrintTree(const string &prefix, const AvlNode *node, bool isRight) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::prettyPrintTree(const string &prefix, const AvlNode *node, bool isRight) const
     {
         if (node == nullptr) // Return if node is null
             return;
@@ -518,20 +840,26 @@ private:
         prettyPrintTree(prefix + (isRight ? "│   " : "    "), node->left, false); // Recursively traverse left subtree
     }
 
-    template <typename Key, typename Value>
-    int AvlTree<Key, Value>::height(AvlNode *t) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::height(AvlNode *t) const
     {
         return t == nullptr ? -1 : t->height; // Return -1 if node is null, else return height of node
     }
 
-    template <typename Key, typename Value>
-    int AvlTree<Key, Value>::max(int lhs, int rhs) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::count(AvlNode *t) const
+    {
+        return t == nullptr ? 0 : t->count; // Return 0 if node is null, else return size of its subtree
+    }
+
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::max(int lhs, int rhs) const
     {
         return lhs > rhs ? lhs : rhs; // Return maximum of two integers
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::check_balance() const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::check_balance() const
     {
         if (root != nullptr)
         { // Check balance only if root is not null
@@ -539,8 +867,8 @@ private:
         }
     }
 
-    template <typename Key, typename Value>
-    int AvlTree<Key, Value>::check_balance(AvlNode *node) const
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::check_balance(AvlNode *node) const
     {
         if (node == nullptr)
         { // Return -1 if node is null
@@ -569,180 +897,164 @@ private:
                                         ", Found: " + std::to_string(node->height));
         }
 
+        // Check if the node's count matches the counts of its subtrees
+        if (count(node->left) + count(node->right) + 1 != node->count)
+        {
+            throw std::invalid_argument("Node with key " + std::to_string(node->k) +
+                                        " has incorrect count. Found: " + std::to_string(node->count));
+        }
+
         return calculatedNodeHeight; // Return calculated height of node
     }
 
     // getValues() function to retrieve a value associated with the given key from the tree.
-    template <typename Key, typename Value>
-    Value &AvlTree<Key, Value>::getValues(Key K)
-    {
-        return getValues(K, root);
-    }
-
-    // Overloaded operator [] to retrieve a value associated with the given key from the tree.
-    template <typename Key, typename Value>
-    Value &AvlTree<Key, Value>::operator[](const Key &K)
-    {
-        return bracketHelper(K, root);
-    }
-
-    // Helper function for getValues() to traverse the tree and find the value associated with the given key.
-    template <typename Key, typename Value>
-    Value &AvlTree<Key, Value>::getValues(Key x, AvlNode *t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    template <typename K>
+    Value &AvlTree<Key, Value, NodeAllocator>::getValues(const K &key)
     {
+        AvlNode *t = findNode(key);
         if (t == nullptr)
         {
             throw std::runtime_error("Key not found in the tree.");
         }
-
-        if (x < t->k)
-            return getValues(x, t->left);
-        else if (t->k < x)
-            return getValues(x, t->right);
-        else
-            return t->v; // Match found
+        return t->v;
     }
 
-    // Helper function for operator[] to traverse the tree and find the value associated with the given key.
-    template <typename Key, typename Value>
-    Value &AvlTree<Key, Value>::bracketHelper(Key x, AvlNode *&t)
+    // Overloaded operator [] to retrieve a value associated with the given key from the tree, adding
+    // a default constructed value when the key is not present.
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    Value &AvlTree<Key, Value, NodeAllocator>::operator[](const Key &K)
     {
-        if (t == nullptr)
-        {
-            t = new AvlNode{x, Value{}, nullptr, nullptr, 0};
-            return t->v; // New node created
-        }
-        if (x < t->k)
-            return bracketHelper(x, t->left);
-        else if (t->k < x)
-            return bracketHelper(x, t->right);
-        else
-            return t->v; // Key found
+        return emplace(K);
     }
 
-    // getKeys() function to retrieve all the keys stored in the tree in level order.
-    template <typename Key, typename Value>
-    vector<Key> AvlTree<Key, Value>::getKeys()
+    // getKeys() function to retrieve all the keys stored in the tree in level order, in one pass over a
+    // queue of the nodes whose keys come next.
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    vector<Key> AvlTree<Key, Value, NodeAllocator>::getKeys() const
     {
         vector<Key> keys;
-        int h = height(root);
-        for (int i = 1; i <= h; i++)
+        vector<AvlNode *> queue;
+        if (root != nullptr)
+            queue.push_back(root);
+        keys.reserve(size());
+        for (size_t i = 0; i < queue.size(); ++i)
         {
-            getKeys(keys, root, i);
+            AvlNode *t = queue[i];
+            keys.push_back(t->k);
+            if (t->left != nullptr)
+                queue.push_back(t->left);
+            if (t->right != nullptr)
+                queue.push_back(t->right);
         }
         return keys;
     }
 
-    // Helper function for getKeys() to traverse the tree and store the keys in the vector.
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::getKeys(vector<Key> &keys, AvlNode *node, int level)
+    // size() function to get the size of the tree, which the root keeps track of.
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::size() const
     {
-        if (node == nullptr)
-        {
-            return;
-        }
-        if (level == 1)
-        {
-            keys.emplace_back(node->k);
-        }
-        else if (level > 1)
-        {
-            getKeys(keys, node->left, level - 1);
-            getKeys(keys, node->right, level - 1);
-        }
+        return count(root);
     }
 
-    // size() function to calculate the size of the tree.
-    template <typename Key, typename Value>
-    int AvlTree<Key, Value>::size()
+    // rank() function to count the keys less than the given key, adding up the left subtrees of the
+    // nodes where the search goes right.
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    int AvlTree<Key, Value, NodeAllocator>::rank(const Key &K) const
     {
-        return size(root);
-    }
-
-    // Helper function for size() to traverse the tree and count the number of nodes.
-    template <typename Key, typename Value>
-    int AvlTree<Key, Value>::size(AvlNode *node)
-    {
-        if (node == nullptr)
-        {
-            return 0;
-        }
-        else
+        int less = 0;
+        AvlNode *t = root;
+        while (t != nullptr)
         {
-            return (size(node->left) + 1 + size(node->right));
+            if (K < t->k)
+                t = t->left;
+            else if (t->k < K)
+            {
+                less += count(t->left) + 1;
+                t = t->right;
+            }
+            else
+                return less + count(t->left);
         }
+        return less;
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(ostream &file, AvlTree<string, map<string, int>> &tree, AvlNode *t)
+    // select() function to find the key at a position, steering by the size of the left subtrees.
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    const Key &AvlTree<Key, Value, NodeAllocator>::select(int i) const
     {
-        // Recursively traverse the tree and write the node values to the output stream
-        if (t == nullptr)
+        if (i < 0 || i >= size())
         {
-            return;
+            throw std::out_of_range("Position " + std::to_string(i) + " is outside the tree.");
         }
-        // print current node
-        file << t->k << " ";
-        for (auto &p : t->v)
+
+        AvlNode *t = root;
+        while (true)
         {
-            file << p.first << " ";  // Write the key of the pair
-            file << p.second << " "; // Write the value of the pair
+            int left = count(t->left);
+            if (i < left)
+                t = t->left;
+            else if (i > left)
+            {
+                i -= left + 1;
+                t = t->right;
+            }
+            else
+                return t->k;
         }
-        file << "; ";
-
-        writeIndex(file, tree, t->left);  // Traverse left subtree
-        writeIndex(file, tree, t->right); // Traverse right subtree
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(ostream &file, AvlTree<string, set<string>> &tree, AvlNode *t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(ostream &file, AvlTree<string, map<string, int>> &)
     {
-        // Recursively traverse the tree and write the node values to the output stream
-        if (t == nullptr)
-        {
-            return;
-        }
-        // print current node
-        file << t->k << " ";
-        for (auto &p : t->v)
-        {
-            file << p << " "; // Write the element of the set
-        }
-        file << "; ";
-
-        writeIndex(file, tree, t->left);  // Traverse left subtree
-        writeIndex(file, tree, t->right); // Traverse right subtree
+        // Write the node values to the output stream in ascending key order
+        inOrder([&file](AvlNode *t) {
+            file << t->k << " ";
+            for (auto &p : t->v)
+            {
+                file << p.first << " ";  // Write the key of the pair
+                file << p.second << " "; // Write the value of the pair
+            }
+            file << "; ";
+        });
     }
 
-    template <typename Key, typename Value>
-    void AvlTree<Key, Value>::writeIndex(ostream &file, AvlTree<string, document> &tree, AvlNode *t)
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(ostream &file, AvlTree<string, set<string>> &)
     {
-        // Recursively traverse the tree and write the node values to the output stream
-        if (t == nullptr)
-        {
-            return;
-        }
-        // print current node
-        file << t->k << " ";
-        file << t->v.title << endl;          // Write the title of the document
-        file << t->v.identifier << ' ';      // Write the identifier of the document
-        file << t->v.publicationDate << ' '; // Write the publication date of the document
-        file << t->v.authorName << endl;     // Write the author name of the document
-
-        // Replace all whitespace characters in the content with a space
-        for (auto &ch : t->v.content)
-        {
-            if (isspace(ch))
+        // Write the node values to the output stream in ascending key order
+        inOrder([&file](AvlNode *t) {
+            file << t->k << " ";
+            for (auto &p : t->v)
             {
-                ch = ' ';
+                file << p << " "; // Write the element of the set
             }
-        }
+            file << "; ";
+        });
+    }
 
-        file << t->v.content << endl; // Write the content of the document
+    template <typename Key, typename Value, template <typename> class NodeAllocator>
+    void AvlTree<Key, Value, NodeAllocator>::writeIndex(ostream &file, AvlTree<string, document> &)
+    {
+        // Write the node values to the output stream in ascending key order
+        inOrder([&file](AvlNode *t) {
+            file << t->k << " ";
+            file << t->v.title << endl;          // Write the title of the document
+            file << t->v.identifier << ' ';      // Write the identifier of the document
+            file << t->v.publicationDate << ' '; // Write the publication date of the document
+            file << t->v.authorName << endl;     // Write the author name of the document
+
+            // Replace all whitespace characters in the content with a space
+            for (auto &ch : t->v.content)
+            {
+                if (isspace(ch))
+                {
+                    ch = ' ';
+                }
+            }
 
-        writeIndex(file, tree, t->left);  // Traverse left subtree
-        writeIndex(file, tree, t->right); // Traverse right subtree
+            file << t->v.content << endl; // Write the content of the document
+        });
     }
-}
 
 #endif // AVLTREE_
\ No newline at end of file
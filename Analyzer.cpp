@@ -0,0 +1,27 @@
+#include "Analyzer.h"
+
+Analyzer::Analyzer(size_t stemCacheCapacity) : stemCache{stemCacheCapacity}
+{
+}
+
+bool Analyzer::analyzeWord(std::string_view word, const StopWordSet &stopWords, std::string &term)
+{
+    bool found = false;
+    analyze(word, stopWords, [&term, &found](std::string &token) {
+        term = token;
+        found = true;
+    });
+    return found;
+}
+
+bool Analyzer::normalize(std::string_view word, std::string &normalized)
+{
+    normalized.clear();
+    Tokenizer::forEachToken(word, scratch, [&normalized](std::string &token) { normalized += token; });
+    return !normalized.empty();
+}
+
+const StemCache::Statistics &Analyzer::stemStatistics() const
+{
+    return stemCache.statistics();
+}
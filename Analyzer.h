@@ -0,0 +1,48 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <string>
+#include <string_view>
+
+#include "StemCache.h"
+#include "StopWords.h"
+#include "Tokenizer.h"
+
+// Analyzer turns text into the terms the word index holds: the Tokenizer splits it into lowercase
+// tokens without punctuation, stop words are dropped and the rest are replaced by their Porter2 stems
+// through a StemCache. DocumentParser analyzes documents and Query analyzes query words with it, so a
+// word of a query finds the term its occurrences in the documents were indexed under. Like StemCache it
+// is not thread-safe; every parser and query owns one.
+class Analyzer
+{
+public:
+    explicit Analyzer(size_t stemCacheCapacity = StemCache::DEFAULT_CAPACITY);
+
+    // Calls onTerm(std::string &) for every term of text. The term is only valid during the call.
+    template <typename OnTerm>
+    void analyze(std::string_view text, const StopWordSet &stopWords, OnTerm &&onTerm)
+    {
+        Tokenizer::forEachToken(text, scratch, [this, &stopWords, &onTerm](std::string &token) {
+            if (stopWords.contains(token))
+                return;
+            stemCache.stem(token);
+            onTerm(token);
+        });
+    }
+
+    // Sets term to the term of a single word and returns true, or returns false when the word has no
+    // term because it is all punctuation or a stop word
+    bool analyzeWord(std::string_view word, const StopWordSet &stopWords, std::string &term);
+
+    // Sets normalized to word without punctuation and lowercased, but neither stop word filtered nor
+    // stemmed, which is what a term prefix is matched with. Returns false when nothing is left.
+    bool normalize(std::string_view word, std::string &normalized);
+
+    const StemCache::Statistics &stemStatistics() const;
+
+private:
+    std::string scratch; // token being built, reused from token to token
+    StemCache stemCache;
+};
+
+#endif // ANALYZER_H
@@ -0,0 +1,559 @@
+#include "Benchmark.h"
+#include "DocumentParser.h"
+#include "Index.h"
+#include "rapidjson/document.h"
+#include "rapidjson/istreamwrapper.h"
+#include "FrozenDictionary.h"
+#include "Intersection.h"
+#include "Query.h"
+#include "Scorer.h"
+#include "StopWords.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace std::chrono;
+
+// indexing() builds a fresh index of the given directory once per thread count and prints the
+// throughput of each run next to its speedup over the single-threaded run.
+void Benchmark::indexing(const std::string& path, int maxThreads) {
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "docs" << std::setw(14) << "seconds"
+              << std::setw(14) << "docs/sec" << std::setw(10) << "speedup" << std::setw(12) << "stem hits"
+              << std::endl;
+
+    double baseline = 0;
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        AvlTree<std::string, PostingList> wordTree;
+        HashMap<std::string, std::vector<uint32_t>> personTree;
+        HashMap<std::string, std::vector<uint32_t>> organizationTree;
+        StopWordSet stopWords;
+        DocumentTable documentTable;
+
+        DocumentParser parser;
+        auto start = high_resolution_clock::now();
+        parser.fileSystem(path, wordTree, personTree, organizationTree, stopWords, documentTable, threads);
+        auto stop = high_resolution_clock::now();
+
+        double seconds = duration_cast<microseconds>(stop - start).count() / 1e6;
+        double rate = seconds > 0 ? parser.getDocumentCount() / seconds : 0;
+        if (threads == 1)
+            baseline = rate;
+
+        std::cout << std::setw(8) << threads << std::setw(12) << parser.getDocumentCount()
+                  << std::setw(14) << std::fixed << std::setprecision(3) << seconds
+                  << std::setw(14) << std::setprecision(1) << rate
+                  << std::setw(9) << std::setprecision(2) << (baseline > 0 ? rate / baseline : 0) << "x"
+                  << std::setw(11) << std::setprecision(1) << parser.getStemStatistics().hitRate() * 100 << "%"
+                  << std::endl;
+    }
+}
+
+
+// Times fn() and returns the elapsed wall time in milliseconds
+template <typename Fn>
+static double elapsedMs(Fn fn) {
+    auto start = high_resolution_clock::now();
+    fn();
+    auto stop = high_resolution_clock::now();
+    return duration_cast<microseconds>(stop - start).count() / 1e3;
+}
+
+// Runs the insert/lookup/free cycle of treeAllocation() for one allocator policy and prints a row
+template <template <typename> class NodeAllocator>
+static void runTreeAllocation(const char* name, const std::vector<std::string>& keys,
+                              const std::vector<std::string>& lookups) {
+    auto* tree = new AvlTree<std::string, std::map<std::string, int>, NodeAllocator>;
+    double insert = elapsedMs([&]() {
+        for (const auto& key : keys)
+            (*tree)[key]["doc"]++;
+    });
+
+    size_t found = 0;
+    double lookup = elapsedMs([&]() {
+        for (const auto& key : lookups)
+            found += tree->contains(key);
+    });
+
+    double release = elapsedMs([&]() { delete tree; });
+
+    std::cout << std::setw(8) << name << std::fixed << std::setprecision(2)
+              << std::setw(14) << insert << std::setw(14) << lookup << std::setw(14) << release
+              << std::setw(10) << found << std::endl;
+}
+
+// Returns count distinct random terms of 3 to 12 letters in ascending order, shaped like the vocabulary
+// of a large corpus
+static std::vector<std::string> randomTerms(int count, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(3, 12);
+    std::set<std::string> distinct;
+    while (distinct.size() < static_cast<size_t>(count)) {
+        std::string term(length(rng), ' ');
+        for (auto& ch : term)
+            ch = static_cast<char>(letter(rng));
+        distinct.insert(term);
+    }
+    return std::vector<std::string>(distinct.begin(), distinct.end());
+}
+
+// Looks up every term and every absent term in one word dictionary of termDictionary() and prints a row
+template <typename Dictionary>
+static void runTermDictionary(const char* name, const Dictionary& dictionary,
+                              const std::vector<std::string>& terms, const std::vector<std::string>& absent) {
+    size_t found = 0;
+    double hit = elapsedMs([&]() {
+        for (const auto& term : terms)
+            found += dictionary.find(term)->size();
+    });
+    double miss = elapsedMs([&]() {
+        for (const auto& term : absent)
+            found += dictionary.contains(term);
+    });
+    std::cout << std::setw(10) << name << std::fixed << std::setprecision(1)
+              << std::setw(14) << hit * 1e6 / terms.size() << std::setw(14) << miss * 1e6 / absent.size()
+              << std::setw(10) << found << std::endl;
+}
+
+// Runs the mention and lookup cycle of entityIndex() for one container and prints a row
+template <typename Map>
+static void runEntityIndex(const char* name, const std::vector<std::string>& mentions,
+                           const std::vector<std::string>& lookups) {
+    Map index;
+    double insert = elapsedMs([&]() {
+        for (size_t i = 0; i < mentions.size(); ++i)
+            index[mentions[i]].push_back(static_cast<uint32_t>(i));
+    });
+
+    size_t found = 0;
+    double lookup = elapsedMs([&]() {
+        for (const auto& key : lookups)
+            found += index.contains(key);
+    });
+
+    std::cout << std::setw(8) << name << std::fixed << std::setprecision(1)
+              << std::setw(14) << insert * 1e6 / mentions.size() << std::setw(14) << lookup * 1e6 / lookups.size()
+              << std::setw(10) << found << std::endl;
+}
+
+// treeAllocation() builds the same tree with both node allocators so their insert, lookup and
+// teardown times can be compared directly.
+void Benchmark::treeAllocation(int count) {
+    std::mt19937 rng(42);
+    std::vector<std::string> keys;
+    for (int i = 0; i < count; ++i)
+        keys.push_back("term" + std::to_string(rng()));
+    std::vector<std::string> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+
+    std::cout << std::setw(8) << "nodes" << std::setw(14) << "insert ms" << std::setw(14) << "lookup ms"
+              << std::setw(14) << "free ms" << std::setw(10) << "found" << std::endl;
+    runTreeAllocation<HeapAllocator>("heap", keys, lookups);
+    runTreeAllocation<SlabAllocator>("slab", keys, lookups);
+}
+
+// persistence() writes the word, people, organization and document trees in both the old whitespace
+// text format and the binary format, then reports the file sizes and how long the binary files take
+// to load back.
+void Benchmark::persistence(const std::string& path) {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> personTree;
+    HashMap<std::string, std::vector<uint32_t>> organizationTree;
+    StopWordSet stopWords;
+    DocumentTable documentTable;
+    DocumentParser parser;
+    parser.fileSystem(path, wordTree, personTree, organizationTree, stopWords, documentTable);
+
+    std::string wordText = "bench_words.txt", peopleText = "bench_people.txt";
+    std::string orgText = "bench_orgs.txt", docText = "bench_docs.txt";
+    std::string wordBin = "bench_words.bin", peopleBin = "bench_people.bin";
+    std::string orgBin = "bench_orgs.bin", docBin = "bench_docs.bin";
+
+    // The text format keyed postings by UUID, so rebuild the trees that way for its writer
+    AvlTree<std::string, std::map<std::string, int>> textWords;
+    wordTree.forEach([&](const std::string& term, PostingList& postings) {
+        for (size_t i = 0; i < postings.size(); ++i)
+            textWords[term][documentTable.uuidOf(postings.docs()[i])] = postings.frequencies()[i];
+    });
+    auto textNames = [&documentTable](HashMap<std::string, std::vector<uint32_t>>& names) {
+        AvlTree<std::string, std::set<std::string>> text;
+        names.forEach([&](const std::string& name, std::vector<uint32_t>& postings) {
+            for (uint32_t id : postings)
+                text[name].insert(documentTable.uuidOf(id));
+        });
+        return text;
+    };
+    AvlTree<std::string, std::set<std::string>> textPeople = textNames(personTree);
+    AvlTree<std::string, std::set<std::string>> textOrgs = textNames(organizationTree);
+    AvlTree<std::string, document> textDocuments;
+    for (uint32_t id = 0; id < documentTable.size(); ++id)
+        textDocuments.insert(documentTable.uuidOf(id), documentTable.getDocument(id));
+
+    textWords.writeIndex(wordText, textWords);
+    textPeople.writeIndex(peopleText, textPeople);
+    textOrgs.writeIndex(orgText, textOrgs);
+    textDocuments.writeIndex(docText, textDocuments);
+
+    Index index;
+    index.saveWordData(wordBin, wordTree, documentTable.size());
+    index.saveNameData(peopleBin, personTree, documentTable.size());
+    index.saveNameData(orgBin, organizationTree, documentTable.size());
+    index.saveDocumentData(docBin, documentTable);
+
+    std::cout << std::setw(10) << "index" << std::setw(14) << "text bytes" << std::setw(14) << "binary bytes"
+              << std::setw(10) << "ratio" << std::setw(14) << "load ms" << std::endl;
+    auto report = [](const char* name, const std::string& text, const std::string& binary, double loadMs) {
+        auto textSize = std::filesystem::file_size(text);
+        auto binarySize = std::filesystem::file_size(binary);
+        std::cout << std::setw(10) << name << std::setw(14) << textSize << std::setw(14) << binarySize
+                  << std::setw(9) << std::fixed << std::setprecision(2)
+                  << (binarySize > 0 ? static_cast<double>(textSize) / binarySize : 0) << "x"
+                  << std::setw(14) << loadMs << std::endl;
+        std::filesystem::remove(text);
+        std::filesystem::remove(binary);
+    };
+
+    AvlTree<std::string, PostingList> loadedWords;
+    HashMap<std::string, std::vector<uint32_t>> loadedPeople;
+    HashMap<std::string, std::vector<uint32_t>> loadedOrgs;
+    DocumentTable loadedDocuments;
+    report("words", wordText, wordBin, elapsedMs([&]() { index.loadWordData(wordBin, loadedWords); }));
+    report("people", peopleText, peopleBin, elapsedMs([&]() { index.loadNameData(peopleBin, loadedPeople); }));
+    report("orgs", orgText, orgBin, elapsedMs([&]() { index.loadNameData(orgBin, loadedOrgs); }));
+    report("docs", docText, docBin, elapsedMs([&]() { index.loadDocumentData(docBin, loadedDocuments); }));
+}
+
+// intersection() intersects a list of count random document IDs with lists 1, 8, 64 and 512 times as
+// long. The set column is the per-document find() the query used to do on std::set postings.
+void Benchmark::intersection(int count) {
+    std::mt19937 rng(42);
+    auto randomList = [&rng](size_t size, uint32_t range) {
+        std::set<uint32_t> ids;
+        std::uniform_int_distribution<uint32_t> pick(0, range - 1);
+        while (ids.size() < size)
+            ids.insert(pick(rng));
+        return std::vector<uint32_t>(ids.begin(), ids.end());
+    };
+
+    std::cout << std::setw(8) << "ratio" << std::setw(10) << "matches" << std::setw(12) << "set ms"
+              << std::setw(12) << "merge ms" << std::setw(12) << "gallop ms" << std::setw(12) << "simd ms"
+              << std::setw(12) << "auto ms" << std::endl;
+    const int rounds = 20;
+    for (size_t ratio : {1, 8, 64, 512}) {
+        size_t longSize = count * ratio;
+        std::vector<uint32_t> a = randomList(count, static_cast<uint32_t>(longSize * 4));
+        std::vector<uint32_t> b = randomList(longSize, static_cast<uint32_t>(longSize * 4));
+        std::set<uint32_t> bSet(b.begin(), b.end());
+        std::vector<uint32_t> out(a.size());
+
+        size_t matches = 0;
+        double set = elapsedMs([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                matches = 0;
+                for (uint32_t id : a)
+                    if (bSet.find(id) != bSet.end())
+                        out[matches++] = id;
+            }
+        });
+        auto time = [&](size_t (*kernel)(const uint32_t*, size_t, const uint32_t*, size_t, uint32_t*)) {
+            return elapsedMs([&]() {
+                for (int r = 0; r < rounds; ++r)
+                    kernel(a.data(), a.size(), b.data(), b.size(), out.data());
+            });
+        };
+
+        std::cout << std::setw(8) << ratio << std::setw(10) << matches << std::fixed << std::setprecision(3)
+                  << std::setw(12) << set << std::setw(12) << time(Intersection::mergeIntersect)
+                  << std::setw(12) << time(Intersection::gallopIntersect)
+                  << std::setw(12) << time(Intersection::simdIntersect)
+                  << std::setw(12) << time(Intersection::intersect) << std::endl;
+    }
+}
+
+// Returns the text of every document below path
+static std::vector<std::string> loadTexts(const std::string& path) {
+    std::vector<std::string> texts;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".json")
+            continue;
+        std::ifstream ifs(entry.path());
+        rapidjson::IStreamWrapper isw(ifs);
+        rapidjson::Document json;
+        json.ParseStream(isw);
+        if (json.IsObject() && json.HasMember("text") && json["text"].IsString())
+            texts.emplace_back(json["text"].GetString(), json["text"].GetStringLength());
+    }
+    return texts;
+}
+
+// tokenizer() loads the text of every document first, so only the tokenizers themselves are timed.
+// The old tokenizer is the istringstream split followed by the remove_if and transform passes over
+// each token that DocumentParser used before the Tokenizer replaced them. Neither stems.
+void Benchmark::tokenizer(const std::string& path) {
+    std::vector<std::string> texts = loadTexts(path);
+    size_t bytes = 0;
+    for (const auto& text : texts)
+        bytes += text.size();
+
+    const int rounds = 5;
+    size_t oldTokens = 0;
+    double oldMs = elapsedMs([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            oldTokens = 0;
+            for (const auto& text : texts) {
+                std::vector<std::string> tokens;
+                std::istringstream iss(text);
+                std::string token;
+                while (iss >> token) {
+                    token.erase(std::remove_if(token.begin(), token.end(), [](unsigned char c) {
+                        return std::ispunct(c) || c == '\'';
+                    }), token.end());
+                    std::transform(token.begin(), token.end(), token.begin(), [](unsigned char c) {
+                        return std::tolower(c);
+                    });
+                    if (!token.empty())
+                        tokens.push_back(token);
+                }
+                oldTokens += tokens.size();
+            }
+        }
+    });
+
+    size_t newTokens = 0;
+    std::string scratch;
+    double newMs = elapsedMs([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            newTokens = 0;
+            for (const auto& text : texts)
+                Tokenizer::forEachToken(text, scratch, [&newTokens](std::string&) { newTokens++; });
+        }
+    });
+
+    double megabytes = bytes * rounds / 1e6;
+    std::cout << std::setw(12) << "tokenizer" << std::setw(12) << "tokens" << std::setw(12) << "ms"
+              << std::setw(12) << "MB/s" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(12) << "istream" << std::setw(12) << oldTokens << std::setw(12) << oldMs
+              << std::setw(12) << (oldMs > 0 ? megabytes / (oldMs / 1e3) : 0) << std::endl;
+    std::cout << std::setw(12) << "single" << std::setw(12) << newTokens << std::setw(12) << newMs
+              << std::setw(12) << (newMs > 0 ? megabytes / (newMs / 1e3) : 0) << std::endl;
+}
+
+// stopWords() runs the check the parser makes for every token against the tree it used to keep the
+// stop list in and against the perfect hash that replaced it.
+void Benchmark::stopWords(const std::string& path) {
+    std::vector<std::string> tokens;
+    std::string scratch;
+    for (const auto& text : loadTexts(path))
+        Tokenizer::forEachToken(text, scratch, [&tokens](std::string& token) { tokens.push_back(token); });
+
+    AvlTree<std::string, std::string> tree;
+    for (std::string_view word : ENGLISH_STOP_WORDS)
+        tree.insert(std::string(word), std::string(word));
+    StopWordSet set;
+
+    const int rounds = 5;
+    size_t treeStops = 0, setStops = 0;
+    double treeMs = elapsedMs([&]() {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& token : tokens)
+                treeStops += tree.contains(token);
+    });
+    double setMs = elapsedMs([&]() {
+        for (int r = 0; r < rounds; ++r)
+            for (const auto& token : tokens)
+                setStops += set.contains(token);
+    });
+
+    double lookups = static_cast<double>(tokens.size()) * rounds;
+    std::cout << std::setw(10) << "store" << std::setw(12) << "lookups" << std::setw(12) << "stops"
+              << std::setw(12) << "ms" << std::setw(12) << "ns/lookup" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "avl" << std::setw(12) << tokens.size() << std::setw(12) << treeStops / rounds
+              << std::setw(12) << treeMs << std::setw(12) << treeMs * 1e6 / lookups << std::endl;
+    std::cout << std::setw(10) << "hash" << std::setw(12) << tokens.size() << std::setw(12) << setStops / rounds
+              << std::setw(12) << setMs << std::setw(12) << setMs * 1e6 / lookups << std::endl;
+}
+
+// entityIndex() draws count mentions from count / 4 distinct names, like the people and organizations
+// of a corpus where the same names come up in many documents, then looks up every name plus as many
+// names that were never mentioned.
+void Benchmark::entityIndex(int count) {
+    std::mt19937 rng(42);
+    std::vector<std::string> names;
+    for (int i = 0; i < count / 4 + 1; ++i)
+        names.push_back("person " + std::to_string(rng()));
+    std::vector<std::string> mentions;
+    for (int i = 0; i < count; ++i)
+        mentions.push_back(names[rng() % names.size()]);
+    std::vector<std::string> lookups = names;
+    for (size_t i = 0; i < names.size(); ++i)
+        lookups.push_back("nobody " + std::to_string(rng()));
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+
+    std::cout << std::setw(8) << "index" << std::setw(14) << "insert ns" << std::setw(14) << "lookup ns"
+              << std::setw(10) << "found" << std::endl;
+    runEntityIndex<AvlTree<std::string, std::vector<uint32_t>>>("avl", mentions, lookups);
+    runEntityIndex<HashMap<std::string, std::vector<uint32_t>>>("hash", mentions, lookups);
+}
+
+// treeOperations() inserts count distinct random terms, shaped like the vocabulary of a large corpus,
+// into a word tree through operator[] as ingestion does, then looks every term up with getValues()
+// and as many absent terms with contains(). Last it saves the tree and times loading it back.
+void Benchmark::treeOperations(int count) {
+    std::mt19937 rng(42);
+    std::vector<std::string> terms = randomTerms(count, rng);
+    std::shuffle(terms.begin(), terms.end(), rng);
+    std::vector<std::string> absent;
+    for (const auto& term : terms)
+        absent.push_back(term + "#");
+
+    AvlTree<std::string, PostingList> tree;
+    double insert = elapsedMs([&]() {
+        for (const auto& term : terms)
+            tree[term].add(0);
+    });
+    std::shuffle(terms.begin(), terms.end(), rng);
+    size_t found = 0;
+    double hit = elapsedMs([&]() {
+        for (const auto& term : terms)
+            found += tree.getValues(term).size();
+    });
+    double miss = elapsedMs([&]() {
+        for (const auto& term : absent)
+            found += tree.contains(term);
+    });
+
+    Index index;
+    std::string file = "bench_avl.bin";
+    index.saveWordData(file, tree, 1);
+    AvlTree<std::string, PostingList> loaded;
+    double load = elapsedMs([&]() { index.loadWordData(file, loaded); });
+    std::filesystem::remove(file);
+
+    std::cout << std::setw(10) << "terms" << std::setw(14) << "insert ns" << std::setw(14) << "hit ns"
+              << std::setw(14) << "miss ns" << std::setw(14) << "load ns" << std::setw(10) << "found" << std::endl;
+    std::cout << std::fixed << std::setprecision(1) << std::setw(10) << count
+              << std::setw(14) << insert * 1e6 / count << std::setw(14) << hit * 1e6 / count
+              << std::setw(14) << miss * 1e6 / count << std::setw(14) << load * 1e6 / count
+              << std::setw(10) << found << std::endl;
+}
+
+// termDictionary() builds the same vocabulary of count random terms as an AvlTree and as a
+// FrozenDictionary and looks every term up in both in random order, followed by as many absent terms.
+void Benchmark::termDictionary(int count) {
+    std::mt19937 rng(42);
+    std::vector<std::string> terms = randomTerms(count, rng);
+    std::vector<std::pair<std::string, PostingList>> entries;
+    for (size_t i = 0; i < terms.size(); ++i)
+        entries.emplace_back(terms[i], PostingList{{static_cast<uint32_t>(i), 1}});
+
+    AvlTree<std::string, PostingList> tree;
+    tree.buildFromSorted(entries.begin(), entries.end());
+    FrozenDictionary<PostingList> frozen(std::make_move_iterator(entries.begin()),
+                                         std::make_move_iterator(entries.end()));
+
+    std::shuffle(terms.begin(), terms.end(), rng);
+    std::vector<std::string> absent;
+    for (const auto& term : terms)
+        absent.push_back(term + "#");
+
+    std::cout << std::setw(10) << "dictionary" << std::setw(14) << "hit ns" << std::setw(14) << "miss ns"
+              << std::setw(10) << "found" << std::endl;
+    runTermDictionary("avl", tree, terms, absent);
+    runTermDictionary("frozen", frozen, terms, absent);
+}
+
+// topK() indexes the documents in path and asks for the best 1, 15 and 100 documents of disjunctive
+// queries over its most common terms, each on its own and together with a rarer term, once scoring
+// every matching document and once skipping the ones that cannot rank. It reports the documents scored
+// per query and the time per query of both, and how many queries ranked differently, which should be
+// none.
+void Benchmark::topK(const std::string& path) {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> personTree;
+    HashMap<std::string, std::vector<uint32_t>> organizationTree;
+    StopWordSet stopWords;
+    DocumentTable documentTable;
+    DocumentParser parser;
+    parser.fileSystem(path, wordTree, personTree, organizationTree, stopWords, documentTable);
+
+    // The terms by descending document frequency
+    std::vector<std::pair<size_t, std::string>> terms;
+    wordTree.forEach([&terms](const std::string& term, PostingList& postings) {
+        terms.emplace_back(postings.size(), term);
+    });
+    std::sort(terms.begin(), terms.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    const size_t common = 20;
+    if (terms.size() < 5 * common) {
+        std::cout << "Too few terms in " << path << std::endl;
+        return;
+    }
+
+    // Queries are built from the indexed terms directly, so analysis cannot change them
+    auto disjunction = [&terms](std::initializer_list<size_t> ranks) {
+        Query::Expression expression;
+        expression.kind = Query::Expression::OR;
+        for (size_t rank : ranks) {
+            Query::Expression word;
+            word.kind = Query::Expression::WORD;
+            word.word = {Query::Word::TERM, terms[rank].second};
+            expression.operands.push_back(word);
+        }
+        return expression;
+    };
+    std::vector<Query::Expression> queries;
+    for (size_t i = 0; i < common; ++i) {
+        queries.push_back(disjunction({i, (i + 1) % common, (i + 7) % common}));
+        queries.push_back(disjunction({i, 4 * common + i}));
+    }
+
+    CollectionStatistics statistics;
+    statistics.documentCount = documentTable.size();
+    if (documentTable.size() > 0)
+        statistics.averageLength = static_cast<double>(documentTable.totalLength()) / documentTable.size();
+    statistics.lengthOf = [&documentTable](uint32_t id) { return documentTable.lengthOf(id); };
+    Bm25Scorer scorer(statistics);
+
+    std::cout << std::setw(6) << "k" << std::setw(10) << "queries" << std::setw(16) << "scored/query"
+              << std::setw(16) << "pruned/query" << std::setw(12) << "reduction" << std::setw(12) << "ms/query"
+              << std::setw(14) << "pruned ms" << std::setw(10) << "differ" << std::endl;
+    Query query;
+    for (size_t k : {1, 15, 100}) {
+        size_t scored = 0, pruned = 0, differ = 0;
+        std::vector<std::vector<std::pair<uint32_t, double>>> exhaustive, results;
+        query.setPruning(false);
+        double exhaustiveMs = elapsedMs([&]() {
+            for (const auto& expression : queries) {
+                exhaustive.push_back(query.parseQuery(expression, wordTree, personTree, organizationTree, scorer, k));
+                scored += query.documentsScored();
+            }
+        });
+        query.setPruning(true);
+        double prunedMs = elapsedMs([&]() {
+            for (const auto& expression : queries) {
+                results.push_back(query.parseQuery(expression, wordTree, personTree, organizationTree, scorer, k));
+                pruned += query.documentsScored();
+            }
+        });
+        for (size_t i = 0; i < queries.size(); ++i)
+            differ += results[i] != exhaustive[i];
+
+        double count = static_cast<double>(queries.size());
+        std::cout << std::setw(6) << k << std::setw(10) << queries.size() << std::fixed << std::setprecision(1)
+                  << std::setw(16) << scored / count << std::setw(16) << pruned / count
+                  << std::setw(11) << (scored > 0 ? 100.0 * (scored - pruned) / scored : 0) << "%"
+                  << std::setprecision(3) << std::setw(12) << exhaustiveMs / count
+                  << std::setw(14) << prunedMs / count << std::setw(10) << differ << std::endl;
+    }
+}
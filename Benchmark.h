@@ -0,0 +1,51 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+// Micro-benchmarks for the search engine, run with `supersearch bench <name> ...`
+class Benchmark {
+public:
+    Benchmark() = default;
+
+    // Indexes the documents in path with 1..maxThreads threads and reports docs/sec and speedup
+    void indexing(const std::string& path, int maxThreads);
+
+    // Inserts, looks up and frees count string keys with heap allocated and slab allocated tree nodes
+    void treeAllocation(int count);
+
+    // Indexes the documents in path and compares the size of the text and binary persisted indexes
+    // together with the time it takes to load the binary ones
+    void persistence(const std::string& path);
+
+    // Intersects random posting lists of growing length ratios with the old std::set lookups and with
+    // every intersection kernel, reporting the time each takes
+    void intersection(int count);
+
+    // Splits the text of the documents in path with the old istringstream tokenizer and with the
+    // single pass Tokenizer and reports the throughput of both in MB/s
+    void tokenizer(const std::string& path);
+
+    // Looks up every token of the documents in path in the default stop list, stored in an AvlTree
+    // and in a StopWordSet, and reports the time per lookup of both
+    void stopWords(const std::string& path);
+
+    // Records count entity mentions over a set of names and looks every name up again, in an AvlTree
+    // and in a HashMap, and reports the time per insert and per lookup of both
+    void entityIndex(int count);
+
+    // Builds a word tree of count random terms and reports the time per insert, per lookup of a term
+    // in the tree, per lookup of a term that is not and per term when loading the saved tree
+    void treeOperations(int count);
+
+    // Looks up count random terms and as many absent terms in an AvlTree and in a FrozenDictionary of
+    // the same vocabulary and reports the time per lookup of both
+    void termDictionary(int count);
+
+    // Indexes the documents in path and ranks the best k documents of OR queries over its most common
+    // terms, scoring every matching document and skipping the ones that cannot rank, and reports the
+    // documents scored and the time per query of both
+    void topK(const std::string& path);
+};
+
+#endif // BENCHMARK_H
@@ -1,133 +1,324 @@
 #include "DocumentParser.h"
 #include "document.h"
 #include "porter2_stemmer.h"
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 
-#include "rapidjson/istreamwrapper.h"
-#include "rapidjson/document.h"
+#include "rapidjson/reader.h"
+
+namespace {
+    // The fields of an article the index uses. The views point into the buffer the file was parsed in.
+    struct Article {
+        std::string_view uuid, title, text, author, published;
+        std::vector<std::string_view> persons, organizations;
+    };
+
+    // SAX handler that picks the fields of an Article out of the parse events and ignores everything
+    // else, so unused subtrees like thread.social are never built. path holds the key of every open
+    // object or array, "" for the root and for array elements.
+    class ArticleHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ArticleHandler> {
+    public:
+        explicit ArticleHandler(Article &article) : article(article) {}
+
+        bool Key(const char *str, rapidjson::SizeType length, bool) {
+            key = std::string_view(str, length);
+            return true;
+        }
+
+        bool String(const char *str, rapidjson::SizeType length, bool) {
+            std::string_view value(str, length);
+            if (path.size() == 1) {
+                if (key == "uuid") article.uuid = value;
+                else if (key == "title") article.title = value;
+                else if (key == "text") article.text = value;
+                else if (key == "author") article.author = value;
+                else if (key == "published") article.published = value;
+            } else if (path.size() == 4 && key == "name" && path[1] == "entities") {
+                if (path[2] == "persons") article.persons.push_back(value);
+                else if (path[2] == "organizations") article.organizations.push_back(value);
+            }
+            return Default();
+        }
+
+        bool StartObject() { return open(); }
+        bool EndObject(rapidjson::SizeType) { return close(); }
+        bool StartArray() { return open(); }
+        bool EndArray(rapidjson::SizeType) { return close(); }
+
+        bool Default() {
+            key = std::string_view();
+            return true;
+        }
+
+    private:
+        bool open() {
+            path.push_back(key);
+            key = std::string_view();
+            return true;
+        }
+
+        bool close() {
+            path.pop_back();
+            key = std::string_view();
+            return true;
+        }
+
+        Article &article;
+        std::vector<std::string_view> path;
+        std::string_view key;
+    };
+}
 
 DocumentParser::DocumentParser() : documentCount(0) {
     // Constructor implementation
 }
 
 void DocumentParser::readJsonFile(const std::string &filePath,
-                                  AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                                  AvlTree<std::string, std::set<std::string>> &personTree,
-                                  AvlTree<std::string, std::set<std::string>> &organizationTree,
-                                  AvlTree<std::string, std::string> &stopWordsTree,
-                                  AvlTree<std::string, document> &documentTree) {
-    std::ifstream ifs(filePath);
+                                  AvlTree<std::string, PostingList> &wordTree,
+                                  HashMap<std::string, std::vector<uint32_t>> &personTree,
+                                  HashMap<std::string, std::vector<uint32_t>> &organizationTree,
+                                  const StopWordSet &stopWords,
+                                  DocumentTable &documentTable) {
+    // Read the whole file with a single read into the reused buffer
+    std::ifstream ifs(filePath, std::ios::binary | std::ios::ate);
     if (!ifs.is_open()) {
         std::cerr << "Error opening file: " << filePath << std::endl;
         return;
     }
+    buffer.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0);
+    ifs.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    ifs.close();
 
-    rapidjson::IStreamWrapper isw(ifs);
-    rapidjson::Document jsonDoc;
-    jsonDoc.ParseStream(isw);
-
-    // Extracting and processing information from the JSON document
-    std::string uuid = jsonDoc["uuid"].GetString();
-    std::string title = jsonDoc["title"].GetString();
-    std::string text = jsonDoc["text"].GetString();
-    std::string author = jsonDoc["author"].GetString();
-    std::string published = jsonDoc["published"].GetString();
-
-    // Creating a new document object and inserting it into the document tree
-    document newDoc(title, uuid, published, author, text);
-    documentTree.insert(uuid, newDoc);
-
-    // Tokenizing the text and populating the word tree
-    std::vector<std::string> tokens;
-    tokenize(text, tokens);
-    for (const auto& token : tokens) {
-        if (!stopWordsTree.contains(token)) {
-            wordTree[token][uuid]++;
-        }
+    // Parse in place, so the strings are unescaped inside the buffer and never copied
+    Article article;
+    ArticleHandler handler(article);
+    rapidjson::Reader reader;
+    rapidjson::InsituStringStream stream(&buffer[0]);
+    if (reader.Parse<rapidjson::kParseInsituFlag>(stream, handler).IsError()) {
+        std::cerr << "Error parsing file: " << filePath << std::endl;
+        return;
     }
 
-    // Processing entities and populating person and organization trees
-    const auto& entities = jsonDoc["entities"];
-    processEntities(entities["persons"], uuid, personTree);
-    processEntities(entities["organizations"], uuid, organizationTree);
-
-    ifs.close();
-}
+    // Creating a new document object and adding it to the document table, which gives it its ID
+    std::string uuid(article.uuid);
+    document newDoc(std::string(article.title), uuid, std::string(article.published),
+                    std::string(article.author), std::string(article.text));
+    uint32_t id = documentTable.insert(uuid, std::move(newDoc));
 
-// processEntities() takes in a reference to a JSON array of entities, document ID and an AVL tree 
-// and inserts the entity name and its corresponding document ID into the AVL tree.
-void DocumentParser::processEntities(const rapidjson::Value& entities, 
-                                     const std::string& documentId,
-                                     AvlTree<std::string, std::set<std::string>>& entityTree) {
-    for (const auto& entity : entities.GetArray()) {
-        std::string name = entity["name"].GetString();
-        entityTree.insert(name, {documentId});
+    // Tokenizing the text and populating the word tree. A term's position is the number of terms before
+    // it, so stop words do not count and a phrase query, analyzed the same way, lines up with it.
+    uint32_t length = 0;
+    if (positional) {
+        analyzer.analyze(documentTable.getDocument(id).content, stopWords, [&](const std::string &token) {
+            wordTree[token].addPosition(id, length++);
+        });
+    } else {
+        analyzer.analyze(documentTable.getDocument(id).content, stopWords, [&](const std::string &token) {
+            wordTree[token].add(id);
+            length++;
+        });
     }
+    documentTable.setLength(id, length);
+
+    // Processing entities and populating person and organization trees
+    processEntities(article.persons, id, personTree);
+    processEntities(article.organizations, id, organizationTree);
 }
- 
-// tokenize() takes in a string and a vector of strings and tokenizes the string, applies Porter2 stemming, 
-// and stores the tokens in the vector.
-void DocumentParser::tokenize(const std::string& content, std::vector<std::string>& tokens) {
-    std::istringstream iss(content);
-    std::string token;
-    while (iss >> token) {
-        // Process each token
-        cleanToken(token);
-        if (!token.empty()) {
-            Porter2Stemmer::stem(token); // Apply Porter2 stemming
-            tokens.push_back(token);
+
+// processEntities() takes in the entity names of a document, its ID and an entity index and adds the
+// document ID to the postings of every name. Documents are parsed in ID order, so this is an append
+// unless the document re-uses the UUID, and so the ID, of an earlier one.
+void DocumentParser::processEntities(const std::vector<std::string_view>& names,
+                                     uint32_t documentId,
+                                     HashMap<std::string, std::vector<uint32_t>>& entityTree) {
+    for (std::string_view name : names) {
+        std::vector<uint32_t> &postings = entityTree[std::string(name)];
+        if (postings.empty() || postings.back() < documentId) {
+            postings.push_back(documentId);
+        } else {
+            auto pos = std::lower_bound(postings.begin(), postings.end(), documentId);
+            if (*pos != documentId) {
+                postings.insert(pos, documentId); // A name mentioned twice in a document is added once
+            }
         }
     }
 }
  
-// cleanToken() takes in a string and removes punctuation and converts it to lowercase.
-void DocumentParser::cleanToken(std::string& token) {
-    // Remove punctuation and convert to lowercase
-    token.erase(std::remove_if(token.begin(), token.end(), [](char c) {
-        return std::ispunct(c) || c == '\''; // Remove punctuation and apostrophes
-    }), token.end());
- 
-    std::transform(token.begin(), token.end(), token.begin(), [](unsigned char c){
-        return std::tolower(c); // Convert to lowercase
-    });
+// setPositional() chooses whether the documents parsed from now on are indexed with term positions.
+void DocumentParser::setPositional(bool keepPositions) {
+    positional = keepPositions;
 }
- 
+
 // getDocumentCount() returns the total number of documents processed so far.
 int DocumentParser::getDocumentCount() const {
     return documentCount;
 }
+
+// getStemStatistics() adds the counts of this parser's stem cache to those of its workers.
+StemCache::Statistics DocumentParser::getStemStatistics() const {
+    StemCache::Statistics statistics = workerStemStatistics;
+    statistics += analyzer.stemStatistics();
+    return statistics;
+}
  
 // fileSystem() takes in a directory path and multiple AVL trees and recursively reads all the JSON files 
-// in the directory and populates the AVL trees.
+// in the directory and populates the AVL trees. With more than one thread, each worker parses into its
+// own partial index and the partial indexes are merged into the shared trees once all workers are done.
 void DocumentParser::fileSystem(const std::string &directoryPath,
-                                AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                                AvlTree<std::string, std::set<std::string>> &personTree,
-                                AvlTree<std::string, std::set<std::string>> &organizationTree,
-                                AvlTree<std::string, std::string> &stopWordsTree,
-                                AvlTree<std::string, document> &documentTree) {
+                                AvlTree<std::string, PostingList> &wordTree,
+                                HashMap<std::string, std::vector<uint32_t>> &personTree,
+                                HashMap<std::string, std::vector<uint32_t>> &organizationTree,
+                                const StopWordSet &stopWords,
+                                DocumentTable &documentTable,
+                                int threadCount) {
+    // Collect the file list first so the workers can share it
+    std::vector<std::string> files;
     for (const auto &entry : std::filesystem::recursive_directory_iterator(directoryPath)) {
         if (entry.is_regular_file() && entry.path().extension() == ".json") {
-            readJsonFile(entry.path().string(), wordTree, personTree, organizationTree, stopWordsTree, documentTree);
+            files.push_back(entry.path().string());
+        }
+    }
+
+    if (threadCount <= 1 || files.size() < 2) {
+        for (const auto &file : files) {
+            readJsonFile(file, wordTree, personTree, organizationTree, stopWords, documentTable);
             documentCount++;
             if (documentCount % 10000 == 0) {
                 std::cout << documentCount << " documents processed." << std::endl;
             }
         }
+    } else {
+        if (static_cast<size_t>(threadCount) > files.size()) {
+            threadCount = static_cast<int>(files.size());
+        }
+        std::vector<PartialIndex> partials(threadCount);
+        indexInParallel(files, partials, stopWords);
+
+        // Number the documents in file order, so they get the same IDs as in a single-threaded run
+        std::vector<std::pair<int, uint32_t>> byFile(files.size(), {-1, 0});
+        std::vector<std::vector<uint32_t>> globalIds(partials.size());
+        for (size_t p = 0; p < partials.size(); ++p) {
+            for (uint32_t id = 0; id < partials[p].fileOf.size(); ++id) {
+                byFile[partials[p].fileOf[id]] = {static_cast<int>(p), id};
+            }
+            globalIds[p].resize(partials[p].fileOf.size());
+        }
+        for (const auto &doc : byFile) {
+            if (doc.first >= 0) {
+                PartialIndex &partial = partials[doc.first];
+                // The partial tables are emptied after the merge, so their documents can be moved
+                uint32_t id = documentTable.insert(partial.documentTable.uuidOf(doc.second),
+                                                   std::move(partial.documentTable.getDocument(doc.second)));
+                documentTable.setLength(id, partial.documentTable.lengthOf(doc.second));
+                globalIds[doc.first][doc.second] = id;
+            }
+        }
+
+        for (size_t p = 0; p < partials.size(); ++p) {
+            mergePartial(partials[p], globalIds[p], wordTree, personTree, organizationTree);
+        }
+        documentCount += static_cast<int>(files.size());
     }
     std::cout << "Total documents processed: " << documentCount << std::endl;
 }
+
+// indexInParallel() runs one worker per partial index. Workers pull the next unparsed file from a shared
+// counter, so a few large files do not leave the other threads idle.
+void DocumentParser::indexInParallel(const std::vector<std::string> &files,
+                                     std::vector<PartialIndex> &partials,
+                                     const StopWordSet &stopWords) {
+    std::atomic<size_t> nextFile{0};
+    std::atomic<int> processed{documentCount};
+    std::mutex outputMutex;
+
+    std::vector<std::thread> workers;
+    for (auto &partial : partials) {
+        workers.emplace_back([this, &files, &partial, &stopWords, &nextFile, &processed, &outputMutex]() {
+            DocumentParser worker;
+            worker.setPositional(positional);
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+                uint32_t known = partial.documentTable.size();
+                worker.readJsonFile(files[i], partial.wordTree, partial.personTree, partial.organizationTree,
+                                    stopWords, partial.documentTable);
+                if (partial.documentTable.size() > known) {
+                    partial.fileOf.push_back(i);
+                }
+                int done = ++processed;
+                if (done % 10000 == 0) {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    std::cout << done << " documents processed." << std::endl;
+                }
+            }
+            partial.stemStatistics = worker.getStemStatistics();
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+// mergePartial() moves the postings of a worker's partial index into the shared trees, renumbering
+// them with the IDs the worker's documents got in the shared document table. Files sharing a UUID
+// share an ID, and when two workers parsed them the same ID is in both of their postings: word
+// counts are summed and entity postings keep the ID once, like the serial path does.
+void DocumentParser::mergePartial(PartialIndex &partial,
+                                  const std::vector<uint32_t> &globalId,
+                                  AvlTree<std::string, PostingList> &wordTree,
+                                  HashMap<std::string, std::vector<uint32_t>> &personTree,
+                                  HashMap<std::string, std::vector<uint32_t>> &organizationTree) {
+
+    partial.wordTree.forEach([&wordTree, &globalId](const std::string &term, PostingList &postings) {
+        // Local IDs are handed out in file order, so the renumbered list is still sorted
+        postings.renumber(globalId);
+        PostingList &merged = wordTree[term];
+        if (merged.empty()) {
+            merged = std::move(postings);
+        } else {
+            merged.merge(postings);
+        }
+    });
+
+    auto mergeEntities = [&globalId](HashMap<std::string, std::vector<uint32_t>> &from,
+                                     HashMap<std::string, std::vector<uint32_t>> &into) {
+        from.forEach([&into, &globalId](const std::string &name, std::vector<uint32_t> &docs) {
+            auto &merged = into[name];
+            size_t middle = merged.size();
+            for (uint32_t id : docs) {
+                merged.push_back(globalId[id]);
+            }
+            // A document that shares the ID of an earlier one can move ahead of the worker's others
+            std::sort(merged.begin() + middle, merged.end());
+            std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end());
+            merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+        });
+    };
+    mergeEntities(partial.personTree, personTree);
+    mergeEntities(partial.organizationTree, organizationTree);
+
+    workerStemStatistics += partial.stemStatistics;
+
+    partial.wordTree.makeEmpty();
+    partial.personTree.makeEmpty();
+    partial.organizationTree.makeEmpty();
+    partial.documentTable.makeEmpty();
+}
  
-// readStopWords() takes in a file path and an AVL tree and reads all the stop words from the file and 
-// populates the AVL tree.
-void DocumentParser::readStopWords(const std::string& filePath, AvlTree<std::string, std::string>& stopWordsTree) {
+// readStopWords() takes in a file path and a stop word set and replaces the set by the words of the
+// file, one per line.
+void DocumentParser::readStopWords(const std::string& filePath, StopWordSet& stopWords) {
     std::ifstream file(filePath);
+    std::vector<std::string> words;
     std::string word;
     while (getline(file, word)) {
-        stopWordsTree.insert(word, word); // Populating the stop words tree
+        words.push_back(word);
     }
+    stopWords = StopWordSet(words); // The set is built once from the whole list
 }
\ No newline at end of file
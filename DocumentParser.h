@@ -2,47 +2,81 @@
 #define DOCUMENTPARSER_H
 
 #include "document.h"
-#include "AvlTree.h"
+#include "DocumentTable.h"
+#include "AVLTree.h"
+#include "HashMap.h"
+#include "PostingList.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 
-#include "porter2_stemmer.h"
-#include "rapidjson/document.h"
-#include "rapidjson/istreamwrapper.h"
+#include <string_view>
+
+#include "Analyzer.h"
+#include "StemCache.h"
+#include "StopWords.h"
 
 class DocumentParser {
 public:
     DocumentParser();
 
     void readJsonFile(const std::string &filePath,
-                      AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                      AvlTree<std::string, std::set<std::string>> &personTree,
-                      AvlTree<std::string, std::set<std::string>> &organizationTree,
-                      AvlTree<std::string, std::string> &stopWordsTree,
-                      AvlTree<std::string, document> &documentTree);
-
-    void tokenize(const std::string& content, std::vector<std::string>& tokens);
+                      AvlTree<std::string, PostingList> &wordTree,
+                      HashMap<std::string, std::vector<uint32_t>> &personTree,
+                      HashMap<std::string, std::vector<uint32_t>> &organizationTree,
+                      const StopWordSet &stopWords,
+                      DocumentTable &documentTable);
 
+    // Indexes every .json file below directoryPath, using threadCount worker threads
     void fileSystem(const std::string &directoryPath,
-                    AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                    AvlTree<std::string, std::set<std::string>> &personTree,
-                    AvlTree<std::string, std::set<std::string>> &organizationTree,
-                    AvlTree<std::string, std::string> &stopWordsTree,
-                    AvlTree<std::string, document> &documentTree);
+                    AvlTree<std::string, PostingList> &wordTree,
+                    HashMap<std::string, std::vector<uint32_t>> &personTree,
+                    HashMap<std::string, std::vector<uint32_t>> &organizationTree,
+                    const StopWordSet &stopWords,
+                    DocumentTable &documentTable,
+                    int threadCount = 1);
+
+    void readStopWords(const std::string& filePath, StopWordSet& stopWords);
 
-    void readStopWords(const std::string& filePath, AvlTree<std::string, std::string>& stopWordsTree);
+    // Whether the postings also keep the position of every occurrence, which phrase and proximity
+    // queries need. Off by default.
+    void setPositional(bool keepPositions);
 
     int getDocumentCount() const; // Function to get document count
 
+    // Hit and miss counts of the stem caches of this parser and of its parallel workers
+    StemCache::Statistics getStemStatistics() const;
+
 private:
     int documentCount;
+    bool positional = false;
+    std::string buffer;  // contents of the file being parsed, reused from file to file
+    Analyzer analyzer; // turns document text into terms, the same way Query turns query words into them
+    StemCache::Statistics workerStemStatistics; // counts of the caches of finished parallel workers
+
+    // Thread-local slice of the index filled by one worker during parallel ingestion
+    struct PartialIndex {
+        AvlTree<std::string, PostingList> wordTree;
+        HashMap<std::string, std::vector<uint32_t>> personTree;
+        HashMap<std::string, std::vector<uint32_t>> organizationTree;
+        DocumentTable documentTable;
+        std::vector<size_t> fileOf; // index into the file list of every document in documentTable
+        StemCache::Statistics stemStatistics;
+    };
+
+    void indexInParallel(const std::vector<std::string> &files,
+                         std::vector<PartialIndex> &partials,
+                         const StopWordSet &stopWords);
+    void mergePartial(PartialIndex &partial,
+                      const std::vector<uint32_t> &globalId,
+                      AvlTree<std::string, PostingList> &wordTree,
+                      HashMap<std::string, std::vector<uint32_t>> &personTree,
+                      HashMap<std::string, std::vector<uint32_t>> &organizationTree);
 
-    void cleanToken(std::string& token);
-    void processEntities(const rapidjson::Value& entities, 
-                         const std::string& documentId,
-                         AvlTree<std::string, std::set<std::string>>& entityTree);
+    void processEntities(const std::vector<std::string_view>& names,
+                         uint32_t documentId,
+                         HashMap<std::string, std::vector<uint32_t>>& entityTree);
 };
 
 #endif // DOCUMENTPARSER_H
\ No newline at end of file
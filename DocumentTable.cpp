@@ -0,0 +1,80 @@
+#include "DocumentTable.h"
+
+#include <stdexcept>
+#include <utility>
+
+uint32_t DocumentTable::insert(const std::string &uuid, const document &doc)
+{
+    return insert(uuid, document(doc));
+}
+
+uint32_t DocumentTable::insert(const std::string &uuid, document &&doc)
+{
+    auto found = ids.find(uuid);
+    if (found != ids.end())
+    {
+        documents[found->second] = std::move(doc); // Replace the document of a known UUID
+        return found->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(uuids.size());
+    ids.emplace(uuid, id);
+    uuids.push_back(uuid);
+    documents.push_back(std::move(doc));
+    lengths.push_back(0);
+    return id;
+}
+
+bool DocumentTable::contains(const std::string &uuid) const
+{
+    return ids.find(uuid) != ids.end();
+}
+
+uint32_t DocumentTable::idOf(const std::string &uuid) const
+{
+    auto found = ids.find(uuid);
+    if (found == ids.end())
+        throw std::runtime_error("Document not found: " + uuid);
+    return found->second;
+}
+
+const std::string &DocumentTable::uuidOf(uint32_t id) const
+{
+    return uuids.at(id);
+}
+
+document &DocumentTable::getDocument(uint32_t id)
+{
+    return documents.at(id);
+}
+
+void DocumentTable::setLength(uint32_t id, uint32_t length)
+{
+    uint32_t &stored = lengths.at(id);
+    lengthSum = lengthSum - stored + length;
+    stored = length;
+}
+
+uint32_t DocumentTable::lengthOf(uint32_t id) const
+{
+    return lengths.at(id);
+}
+
+uint64_t DocumentTable::totalLength() const
+{
+    return lengthSum;
+}
+
+uint32_t DocumentTable::size() const
+{
+    return static_cast<uint32_t>(uuids.size());
+}
+
+void DocumentTable::makeEmpty()
+{
+    uuids.clear();
+    documents.clear();
+    lengths.clear();
+    lengthSum = 0;
+    ids.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef DOCUMENTTABLE_H
+#define DOCUMENTTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// DocumentTable stores every indexed document under a dense integer ID handed out in insertion order.
+// The postings of the word, person and organization indexes refer to documents by this ID; the UUID
+// of a document is only needed again when it is shown to the user.
+class DocumentTable
+{
+public:
+    DocumentTable() = default;
+
+    // Adds a document and returns its ID. A UUID that is already present keeps its ID and gets the
+    // new document, like AvlTree::insert does for a duplicate key.
+    uint32_t insert(const std::string &uuid, const document &doc);
+
+    // Same as above, moving the document into the table instead of copying its text
+    uint32_t insert(const std::string &uuid, document &&doc);
+
+    // Checks if a UUID has been added
+    bool contains(const std::string &uuid) const;
+
+    // Gets the ID of a UUID, throws std::runtime_error when it is not present
+    uint32_t idOf(const std::string &uuid) const;
+
+    // Gets the UUID and the document of an ID, throw std::out_of_range for unknown IDs
+    const std::string &uuidOf(uint32_t id) const;
+    document &getDocument(uint32_t id);
+
+    // Records the number of indexed tokens of a document, which scoring uses to normalize term
+    // frequencies. Documents without a recorded length have length 0.
+    void setLength(uint32_t id, uint32_t length);
+    uint32_t lengthOf(uint32_t id) const;
+
+    // Sum of the lengths of all documents
+    uint64_t totalLength() const;
+
+    // Number of documents, IDs run from 0 to size() - 1
+    uint32_t size() const;
+
+    // Removes all documents, IDs start again at 0
+    void makeEmpty();
+
+private:
+    std::vector<std::string> uuids;                 // UUID of every ID
+    std::vector<document> documents;                // document of every ID
+    std::vector<uint32_t> lengths;                  // length in tokens of every ID
+    uint64_t lengthSum = 0;                         // sum of lengths
+    std::unordered_map<std::string, uint32_t> ids;  // ID of every UUID
+};
+
+#endif // DOCUMENTTABLE_H
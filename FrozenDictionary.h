@@ -0,0 +1,246 @@
+#ifndef FROZENDICTIONARY_H
+#define FROZENDICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// FrozenDictionary is a read-only term dictionary for an index that no longer changes, usable in place
+// of AvlTree<std::string, Value> wherever terms are only looked up or scanned in order. The terms are
+// laid out as an implicit binary search tree in Eytzinger (breadth first) order: the children of slot
+// i are slots 2i and 2i + 1, so the slots of the top levels share cache lines and a lookup can prefetch
+// the next levels before it needs them. Each slot holds the first 8 bytes of its term packed into an
+// integer, which decides almost every comparison without touching the term text. The text of all terms
+// is kept in one buffer and the values in one array, both in key order.
+template <typename Value>
+class FrozenDictionary
+{
+public:
+    FrozenDictionary() = default;
+
+    // Builds the dictionary from (term, value) pairs in strictly ascending term order, throws
+    // std::invalid_argument when they are not. Pass std::move_iterators to move the values in.
+    template <typename InputIterator>
+    FrozenDictionary(InputIterator first, InputIterator last)
+    {
+        offsets.push_back(0);
+        for (; first != last; ++first)
+        {
+            auto &&entry = *first;
+            std::string_view term(entry.first);
+            if (!values.empty() && !(keyAt(values.size() - 1) < term))
+                throw std::invalid_argument("Terms passed to FrozenDictionary are not in ascending order.");
+            text.append(term.data(), term.size());
+            offsets.push_back(static_cast<uint32_t>(text.size()));
+            values.push_back(std::forward<decltype(entry)>(entry).second);
+        }
+
+        slots.resize(values.size() + 1);
+        uint32_t next = 0;
+        layout(1, next);
+    }
+
+    // Gets the value of a term, or nullptr when it is not present
+    const Value *find(std::string_view term) const
+    {
+        size_t rank = lowerRank(term);
+        if (rank == values.size() || keyAt(rank) != term)
+            return nullptr;
+        return &values[rank];
+    }
+
+    bool contains(std::string_view term) const
+    {
+        return find(term) != nullptr;
+    }
+
+    // Gets the value of a term, throws std::runtime_error when it is not present
+    const Value &getValues(std::string_view term) const
+    {
+        const Value *value = find(term);
+        if (value == nullptr)
+            throw std::runtime_error("Key not found in the dictionary.");
+        return *value;
+    }
+
+    int size() const
+    {
+        return static_cast<int>(values.size());
+    }
+
+    bool isEmpty() const
+    {
+        return values.empty();
+    }
+
+    // Calls visit(term, value) for every entry in ascending term order
+    template <typename Visitor>
+    void forEach(Visitor visit) const
+    {
+        for (size_t rank = 0; rank < values.size(); ++rank)
+            visit(keyAt(rank), values[rank]);
+    }
+
+    // Forward iterator over the entries in ascending term order. Dereferencing gives the term and a
+    // reference to its value.
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<std::string_view, Value>;
+        using reference = std::pair<std::string_view, const Value &>;
+
+        // Holds the pair so that it->first and it->second work
+        struct pointer
+        {
+            reference entry;
+            const reference *operator->() const { return &entry; }
+        };
+
+        Iterator() = default;
+
+        reference operator*() const { return reference(dictionary->keyAt(rank), dictionary->values[rank]); }
+        pointer operator->() const { return pointer{**this}; }
+
+        Iterator &operator++()
+        {
+            ++rank;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator old = *this;
+            ++rank;
+            return old;
+        }
+
+        bool operator==(const Iterator &other) const { return rank == other.rank; }
+        bool operator!=(const Iterator &other) const { return rank != other.rank; }
+
+    private:
+        friend class FrozenDictionary;
+        Iterator(const FrozenDictionary *dictionary, size_t rank) : dictionary(dictionary), rank(rank) {}
+
+        const FrozenDictionary *dictionary = nullptr;
+        size_t rank = 0; // position of the entry in term order
+    };
+
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    // Pair of iterators that range-based for loops can walk
+    struct Range
+    {
+        Iterator first, last;
+        Iterator begin() const { return first; }
+        Iterator end() const { return last; }
+    };
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, values.size()); }
+
+    // Iterator to the first entry whose term is not less than term
+    Iterator lower_bound(std::string_view term) const
+    {
+        return Iterator(this, lowerRank(term));
+    }
+
+    // Entries whose term starts with prefix, which sit next to each other in term order
+    Range prefix_range(std::string_view prefix) const
+    {
+        Iterator first = lower_bound(prefix);
+        std::string limit(prefix);
+        while (!limit.empty() && static_cast<unsigned char>(limit.back()) == 0xFF)
+            limit.pop_back();
+        if (limit.empty())
+            return {first, end()};
+        limit.back() = static_cast<char>(static_cast<unsigned char>(limit.back()) + 1);
+        return {first, lower_bound(limit)};
+    }
+
+private:
+    // One node of the implicit search tree
+    struct Slot
+    {
+        uint64_t head; // first 8 bytes of the term, big-endian and zero padded
+        uint32_t rank; // position of the term in term order
+    };
+
+    // Asks the CPU to start loading the cache line of a slot, where the compiler has a way to
+    static void prefetch(const Slot *slot)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(slot);
+#else
+        (void)slot;
+#endif
+    }
+
+    // Packs the first 8 bytes of a term so that comparing two heads as integers orders them like the
+    // terms, except that terms sharing their first 8 bytes (or differing only in trailing zero bytes)
+    // compare equal and need their full text compared
+    static uint64_t headOf(std::string_view term)
+    {
+        uint64_t head = 0;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            head <<= 8;
+            if (i < term.size())
+                head |= static_cast<unsigned char>(term[i]);
+        }
+        return head;
+    }
+
+    std::string_view keyAt(size_t rank) const
+    {
+        return std::string_view(text).substr(offsets[rank], offsets[rank + 1] - offsets[rank]);
+    }
+
+    // Fills the slots below i with the terms in order, handing out ranks with an in-order walk of the
+    // implicit tree. The recursion is as deep as the tree, about log2 of the number of terms.
+    void layout(size_t i, uint32_t &next)
+    {
+        if (i >= slots.size())
+            return;
+        layout(2 * i, next);
+        slots[i].rank = next;
+        slots[i].head = headOf(keyAt(next));
+        next++;
+        layout(2 * i + 1, next);
+    }
+
+    // Returns the rank of the first term not less than term, or size() when there is none. The descent
+    // goes right past every slot whose term is less, so the slot to return is the last one where it
+    // went left: dropping the trailing right turns and that left turn from i leaves its index.
+    size_t lowerRank(std::string_view term) const
+    {
+        uint64_t head = headOf(term);
+        size_t i = 1;
+        while (i < slots.size())
+        {
+            if (16 * i < slots.size())
+                prefetch(&slots[16 * i]); // slots 16i..16i+15, four levels further down
+            const Slot &slot = slots[i];
+            bool less = slot.head < head || (slot.head == head && keyAt(slot.rank) < term);
+            i = 2 * i + less;
+        }
+        while (i & 1)
+            i >>= 1;
+        i >>= 1;
+        return i == 0 ? values.size() : slots[i].rank;
+    }
+
+    std::vector<Slot> slots;       // Eytzinger ordered search tree, slot 0 unused
+    std::string text;              // all terms back to back in term order
+    std::vector<uint32_t> offsets; // start of every term in text, plus the end of the last one
+    std::vector<Value> values;     // value of every term in term order
+};
+
+#endif // FROZENDICTIONARY_H
@@ -0,0 +1,219 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The vendored hash falls through its switch cases on purpose
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#include "util/hash.h"
+#pragma GCC diagnostic pop
+
+// MurmurHash3 of a key, from util/hash.h. Strings hash their characters, other keys their bytes.
+template <typename Key>
+struct MurmurHash
+{
+    static constexpr uint64_t SEED = 0x9e3779b97f4a7c15ULL;
+
+    uint64_t operator()(std::string_view key) const
+    {
+        meta::util::murmur_hash<8> hash(SEED);
+        hash(key.data(), key.size());
+        return static_cast<std::size_t>(hash);
+    }
+
+    template <typename K = Key, typename = std::enable_if_t<!std::is_convertible<K, std::string_view>::value>>
+    uint64_t operator()(const K &key) const
+    {
+        static_assert(std::is_trivially_copyable<K>::value, "MurmurHash needs a string or a plain value key");
+        meta::util::murmur_hash<8> hash(SEED);
+        hash(&key, sizeof(key));
+        return static_cast<std::size_t>(hash);
+    }
+};
+
+// HashMap is an open addressing hash table with Robin Hood probing, usable in place of AvlTree where
+// keys are only ever looked up and never needed in order. Every slot has a control byte holding how
+// far its entry is from the slot its hash points to (0 for an empty slot). An insert takes the slot of
+// any entry that is closer to its home than the new one, so probe sequences stay short and a lookup
+// can stop as soon as it meets an entry closer to home than the key would be. Keys and values live
+// in one flat array, so a lookup touches a few adjacent slots instead of a path of tree nodes.
+template <typename Key, typename Value, typename Hash = MurmurHash<Key>>
+class HashMap
+{
+public:
+    HashMap() = default;
+
+    // Inserts a key-value pair, replacing the value of a key that is already present like
+    // AvlTree::insert does
+    void insert(const Key &key, const Value &value)
+    {
+        (*this)[key] = value;
+    }
+
+    // Calls visit(key, value) for every entry, in no particular order
+    template <typename Visitor>
+    void forEach(Visitor visit)
+    {
+        for (size_t i = 0; i < control.size(); ++i)
+            if (control[i] != EMPTY)
+                visit(static_cast<const Key &>(slots[i].first), slots[i].second);
+    }
+
+    // Checks if a key is present
+    bool contains(const Key &key) const
+    {
+        return find(key) != NOT_FOUND;
+    }
+
+    bool isEmpty() const
+    {
+        return count == 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    // Removes all entries and releases the table
+    void makeEmpty()
+    {
+        control.clear();
+        slots.clear();
+        count = 0;
+    }
+
+    // Removes a key, shifting the entries after it back towards their home slots
+    void remove(const Key &key)
+    {
+        size_t i = find(key);
+        if (i == NOT_FOUND)
+            return;
+
+        size_t next = (i + 1) & mask();
+        while (control[next] > 1)
+        {
+            slots[i] = std::move(slots[next]);
+            control[i] = control[next] - 1;
+            i = next;
+            next = (next + 1) & mask();
+        }
+        slots[i] = Slot();
+        control[i] = EMPTY;
+        count--;
+    }
+
+    // Gets the value of a key, throws std::runtime_error when it is not present
+    Value &getValues(const Key &key)
+    {
+        size_t i = find(key);
+        if (i == NOT_FOUND)
+            throw std::runtime_error("Key not found in the map.");
+        return slots[i].second;
+    }
+
+    // Gets the value of a key, inserting a default constructed value when it is not present
+    Value &operator[](const Key &key)
+    {
+        size_t i = find(key);
+        if (i != NOT_FOUND)
+            return slots[i].second;
+        if ((count + 1) * 8 > control.size() * 7)
+            grow();
+        place(Slot(key, Value()));
+        return slots[find(key)].second;
+    }
+
+private:
+    using Slot = std::pair<Key, Value>;
+
+    static constexpr uint8_t EMPTY = 0;
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    size_t mask() const
+    {
+        return control.size() - 1;
+    }
+
+    // Returns the slot of a key, or NOT_FOUND
+    size_t find(const Key &key) const
+    {
+        if (count == 0)
+            return NOT_FOUND;
+
+        size_t i = hash(key) & mask();
+        for (size_t distance = 1;; ++distance)
+        {
+            // An entry closer to its home than the key would be means the key is not in the table
+            if (control[i] < distance)
+                return NOT_FOUND;
+            if (control[i] == distance && slots[i].first == key)
+                return i;
+            i = (i + 1) & mask();
+        }
+    }
+
+    // Puts an entry that is not in the table yet into its Robin Hood position. Entries displaced on
+    // the way are carried along and placed further on.
+    void place(Slot entry)
+    {
+        size_t i = hash(entry.first) & mask();
+        for (uint8_t distance = 1;; ++distance)
+        {
+            if (control[i] == EMPTY)
+            {
+                control[i] = distance;
+                slots[i] = std::move(entry);
+                count++;
+                return;
+            }
+            if (control[i] < distance)
+            {
+                std::swap(distance, control[i]);
+                std::swap(entry, slots[i]);
+            }
+            if (distance == UINT8_MAX)
+            {
+                // The probe sequence got too long for a control byte, so carry on in a larger table
+                grow();
+                place(std::move(entry));
+                return;
+            }
+            i = (i + 1) & mask();
+        }
+    }
+
+    // Doubles the table and rehashes every entry
+    void grow()
+    {
+        std::vector<uint8_t> oldControl = std::move(control);
+        std::vector<Slot> oldSlots = std::move(slots);
+        size_t capacity = oldControl.size() < MIN_CAPACITY ? MIN_CAPACITY : oldControl.size() * 2;
+        control.assign(capacity, EMPTY);
+        slots = std::vector<Slot>(capacity);
+        count = 0;
+        for (size_t i = 0; i < oldControl.size(); ++i)
+            if (oldControl[i] != EMPTY)
+                place(std::move(oldSlots[i]));
+    }
+
+    uint64_t hash(const Key &key) const
+    {
+        return Hash()(key);
+    }
+
+    std::vector<uint8_t> control; // probe distance + 1 of the entry in every slot, EMPTY when free
+    std::vector<Slot> slots;      // key and value of every slot
+    size_t count = 0;
+};
+
+#endif // HASHMAP_H
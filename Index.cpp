@@ -1,144 +1,317 @@
 #include "Index.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <utility>
+#include <vector>
+
+using IndexFormat::Header;
+using IndexFormat::Reader;
+using IndexFormat::Writer;
 
 // Constructor for Index class
 Index::Index() : documentCount(0) {
     // Initialize documentCount to 0
 }
- 
-// Function to save word data to a file
-void Index::saveWordData(std::string &filepath, AvlTree<std::string, std::map<std::string, int>> &wordTree) {
-    // Write the index tree to the specified filepath
-    wordTree.writeIndex(filepath, wordTree);
+
+// Function to save word data to a file. The posting list of every term comes first, as its number of
+// postings, the (document ID delta, frequency) pair of every posting and a string holding the positions
+// of every posting as deltas, followed by the front-coded term blocks described in IndexFormat.h.
+void Index::saveWordData(std::string &filepath, AvlTree<std::string, PostingList> &wordTree,
+                         uint32_t documentCount, std::string_view wordFile) {
+    std::string payload;
+    Writer out(payload);
+
+    // Write the posting lists in key order, remembering where each one starts
+    std::vector<std::pair<const std::string *, uint64_t>> terms;
+    std::string positions;
+    Writer positionsOut(positions);
+    wordTree.forEach([&](const std::string &term, PostingList &postings) {
+        terms.emplace_back(&term, out.size());
+        out.varint(postings.size());
+        uint32_t previous = 0;
+        for (size_t i = 0; i < postings.size(); ++i) {
+            out.varint(postings.docs()[i] - previous);
+            out.varint(postings.frequencies()[i]);
+            previous = postings.docs()[i];
+        }
+
+        // A loaded list whose positions nothing decoded still has them as they were saved
+        positions.clear();
+        if (postings.savedPositions() != 0 && !wordFile.empty()) {
+            positions = Reader(wordFile.data() + postings.savedPositions(), wordFile.data() + wordFile.size()).view();
+        }
+        for (size_t i = 0; postings.hasPositions() && i < postings.size(); ++i) {
+            uint32_t position = 0;
+            for (auto range = postings.positionsAt(i); range.first != range.second; ++range.first) {
+                positionsOut.varint(*range.first - position);
+                position = *range.first;
+            }
+        }
+        out.str(positions);
+    });
+
+    // Write the terms, every one after the first of a block as the bytes it does not share with the
+    // one before it
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const std::string &term = *terms[i].first;
+        if (i % IndexFormat::TERMS_PER_BLOCK == 0) {
+            offsets.push_back(out.size());
+            out.str(term);
+            out.varint(terms[i].second);
+        } else {
+            const std::string &previous = *terms[i - 1].first;
+            size_t shared = std::mismatch(previous.begin(), previous.end(), term.begin(), term.end()).first -
+                            previous.begin();
+            out.varint(shared);
+            out.str(std::string_view(term).substr(shared));
+            out.varint(terms[i].second - terms[i - 1].second);
+        }
+    }
+    for (uint64_t offset : offsets)
+        out.fixed(offset, 8);
+
+    Header header;
+    header.kind = IndexFormat::WORDS;
+    header.docCount = documentCount;
+    header.entryCount = terms.size();
+    writeFile(filepath, header, payload);
 }
- 
-// Function to save name data to a file
-void Index::saveNameData(std::string &filepath, AvlTree<std::string, std::set<std::string>> &nameTree) {
-    // Write the index tree to the specified filepath
-    nameTree.writeIndex(filepath, nameTree);
+
+// Function to save name data to a file. Each entry is the name followed by its number of postings and
+// the document ID delta of every posting.
+void Index::saveNameData(std::string &filepath, HashMap<std::string, std::vector<uint32_t>> &nameTree,
+                         uint32_t documentCount) {
+    std::string payload;
+    Writer out(payload);
+    std::vector<uint64_t> offsets;
+
+    // The map is unordered, so sort its entries by name first
+    std::vector<std::pair<const std::string *, const std::vector<uint32_t> *>> entries;
+    entries.reserve(nameTree.size());
+    nameTree.forEach([&entries](const std::string &name, std::vector<uint32_t> &postings) {
+        entries.emplace_back(&name, &postings);
+    });
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) { return *a.first < *b.first; });
+
+    // Write the entries in key order, remembering where each one starts
+    for (const auto &entry : entries) {
+        offsets.push_back(out.size());
+        out.str(*entry.first);
+        out.varint(entry.second->size());
+        uint32_t previous = 0;
+        for (uint32_t id : *entry.second) {
+            out.varint(id - previous);
+            previous = id;
+        }
+    }
+    for (uint64_t offset : offsets)
+        out.fixed(offset, 8);
+
+    Header header;
+    header.kind = IndexFormat::NAMES;
+    header.docCount = documentCount;
+    header.entryCount = offsets.size();
+    writeFile(filepath, header, payload);
 }
- 
-// Function to save document data to a file
-void Index::saveDocumentData(std::string &filepath, AvlTree<std::string, document> &documentTree) {
-    // Write the index tree to the specified filepath
-    documentTree.writeIndex(filepath, documentTree);
+
+// Function to save document data to a file. The entries are in ID order, each is the UUID followed by
+// the length, title, identifier, publication date, author name and content of the document.
+void Index::saveDocumentData(std::string &filepath, DocumentTable &documentTable) {
+    std::string payload;
+    Writer out(payload);
+    std::vector<uint64_t> offsets;
+
+    for (uint32_t id = 0; id < documentTable.size(); ++id) {
+        const document &doc = documentTable.getDocument(id);
+        offsets.push_back(out.size());
+        out.str(documentTable.uuidOf(id));
+        out.varint(documentTable.lengthOf(id));
+        out.str(doc.title);
+        out.str(doc.identifier);
+        out.str(doc.publicationDate);
+        out.str(doc.authorName);
+        out.str(doc.content);
+    }
+    for (uint64_t offset : offsets)
+        out.fixed(offset, 8);
+
+    Header header;
+    header.kind = IndexFormat::DOCUMENTS;
+    header.docCount = documentTable.size();
+    header.entryCount = offsets.size();
+    header.totalLength = documentTable.totalLength();
+    writeFile(filepath, header, payload);
 }
- 
+
 // Function to load word data from a file
-void Index::loadWordData(const std::string &filepath, AvlTree<std::string, std::map<std::string, int>> &wordTree) {
-    // Open the specified file
-    std::ifstream file(filepath);
-    
-    // Check if file is open
-    if (!file.is_open()) {
-        std::cerr << "The file cannot open: " << filepath << std::endl;
+void Index::loadWordData(const std::string &filepath, AvlTree<std::string, PostingList> &wordTree,
+                         std::string *wordFile) {
+    std::string data = readFile(filepath);
+    if (data.empty()) {
         return;
     }
- 
-    // Read the key and associated UUIDs and frequencies
-    std::string key, uuid;
-    int frequency;
-    while (!file.eof()) {
-        std::map<std::string, int> currentMap;
-        file >> key;
-        while (!file.eof()) {
-            file >> uuid;
-            if (uuid == ";") {
-                break;
+
+    Header header = IndexFormat::decodeHeader(data.data(), data.size(), IndexFormat::WORDS);
+
+    // Read every term block in order, and the posting list of every term in it
+    const char *payload = data.data() + IndexFormat::HEADER_SIZE;
+    const char *blockTable = data.data() + data.size() - 8 * IndexFormat::blockCount(header);
+    std::vector<std::pair<std::string, PostingList>> entries;
+    entries.reserve(header.entryCount);
+    // Lists already in the tree may refer to the bytes wordFile holds, so those are only replaced for an empty one
+    bool keepFile = wordFile != nullptr && wordTree.isEmpty();
+    for (uint64_t b = 0; b < IndexFormat::blockCount(header); ++b) {
+        uint64_t offset = IndexFormat::payloadOffset(Reader(blockTable + 8 * b, blockTable + 8 * (b + 1)).fixed(8), header);
+        IndexFormat::TermBlockReader terms(Reader(payload + offset, blockTable), IndexFormat::termsInBlock(header, b));
+        while (terms.next()) {
+            Reader in(payload + IndexFormat::payloadOffset(terms.postingsOffset(), header), blockTable);
+            uint64_t count = in.varint();
+            PostingList postings;
+            uint64_t id = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                id += in.varint();
+                int frequency = static_cast<int>(in.varint());
+                postings.add(IndexFormat::documentId(id, header), frequency);
+            }
+            // The positions are only decoded for the phrase and NEAR queries that need them
+            const char *positions = in.position();
+            if (!in.view().empty() && keepFile) {
+                postings.setSavedPositions(positions - data.data());
             }
-            file >> frequency;
-            currentMap.emplace(uuid, frequency);
+            entries.emplace_back(terms.term(), std::move(postings));
         }
-        if (!currentMap.empty()) {
-            // Insert the key and map into the tree
-            wordTree.insert(key, currentMap);
+    }
+
+    if (keepFile) {
+        *wordFile = std::move(data);
+    }
+
+    // saveWordData() writes the terms in key order, so an empty tree is built from them in one pass
+    // instead of by one insert per term
+    auto unordered = std::adjacent_find(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return !(a.first < b.first);
+    });
+    if (wordTree.isEmpty() && unordered == entries.end()) {
+        wordTree.buildFromSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        return;
+    }
+    // Otherwise the postings are merged into those the tree already has for a term
+    for (auto &entry : entries) {
+        PostingList &postings = wordTree[entry.first];
+        if (postings.empty()) {
+            postings = std::move(entry.second);
+        } else {
+            postings.merge(entry.second);
         }
     }
- 
-    // Close the file
-    file.close();
 }
- 
+
 // Function to load name data from a file
-void Index::loadNameData(const std::string &filepath, AvlTree<std::string, std::set<std::string>> &nameTree) {
-    // Open the specified file
-    std::ifstream file(filepath);
-    
-    // Check if file is open
-    if (!file.is_open()) {
-        std::cerr << "The file cannot open: " << filepath << std::endl;
+void Index::loadNameData(const std::string &filepath, HashMap<std::string, std::vector<uint32_t>> &nameTree) {
+    std::string data = readFile(filepath);
+    if (data.empty()) {
         return;
     }
- 
-    // Read the key and associated UUIDs
-    while (!file.eof()) {
-        std::string key, uuid;
-        std::set<std::string> currentSet;
-        file >> key;
- 
-        // Read UUIDs associated with the key until a semicolon is encountered
-        while (file >> uuid && uuid != ";") {
-            currentSet.insert(uuid);
-        }
- 
-        // Add the set to the tree if it's not empty
-        if (!currentSet.empty()) {
-            nameTree.insert(key, currentSet);
+
+    Header header = IndexFormat::decodeHeader(data.data(), data.size(), IndexFormat::NAMES);
+    Reader in(data.data() + IndexFormat::HEADER_SIZE, data.data() + data.size());
+
+    // Read every name with its postings and insert them into the tree
+    for (uint64_t i = 0; i < header.entryCount; ++i) {
+        std::string name = in.str();
+        uint64_t count = in.varint();
+        std::vector<uint32_t> postings;
+        uint64_t id = 0;
+        for (uint64_t j = 0; j < count; ++j) {
+            id += in.varint();
+            postings.push_back(IndexFormat::documentId(id, header));
         }
+        nameTree.insert(name, postings);
     }
- 
-    // Close the file
-    file.close();
 }
- 
-// Function to load document data from a file
-void Index::loadDocumentData(const std::string &filepath, AvlTree<std::string, document> &documentTree) {
-    // Open the specified file
-    std::ifstream file(filepath);
-    
-    // Check if file is open
-    if (!file.is_open()) {
-        std::cerr << "The file cannot open: " << filepath << std::endl;
+
+// Function to load document data from a file. The table is emptied first so that every document gets
+// back the ID it was saved with.
+void Index::loadDocumentData(const std::string &filepath, DocumentTable &documentTable) {
+    std::string data = readFile(filepath);
+    if (data.empty()) {
         return;
     }
- 
+
+    Header header = IndexFormat::decodeHeader(data.data(), data.size(), IndexFormat::DOCUMENTS);
+    Reader in(data.data() + IndexFormat::HEADER_SIZE, data.data() + data.size());
+    documentTable.makeEmpty();
+
     // Read the UUID and associated document information
-    while (!file.eof()) {
-        std::string uuid;
-        file >> uuid;
- 
+    for (uint64_t i = 0; i < header.entryCount; ++i) {
+        std::string uuid = in.str();
+        uint32_t length = static_cast<uint32_t>(in.varint());
         document doc;
-        std::string title;
-        std::string identifier;
-        std::string publicationDate;
-        std::string authorName;
-        std::string content;
- 
-        // Read the rest of the document information
-        std::getline(file, title); // Assuming title is on a new line
-        doc.title = title;
- 
-        file >> identifier;
-        doc.identifier = identifier;
- 
-        file >> publicationDate;
-        doc.publicationDate = publicationDate;
- 
-        std::getline(file, authorName); // Assuming authorName is on a new line
-        doc.authorName = authorName;
- 
-        std::getline(file, content); // Assuming content is on a new line
-        doc.content = content;
- 
-        // If the UUID is not empty, add the document to the tree
-        if (!uuid.empty()) {
-            documentTree.insert(uuid, doc);
+        doc.title = in.str();
+        doc.identifier = in.str();
+        doc.publicationDate = in.str();
+        doc.authorName = in.str();
+        doc.content = in.str();
+        documentTable.setLength(documentTable.insert(uuid, std::move(doc)), length);
+    }
+}
+
+// Function to replace a posting list by one with the positions saveWordData() wrote for it, if it wrote
+// any. The positions of a posting are as many as its frequency.
+void Index::readPositions(std::string_view bytes, PostingList &postings) {
+    if (bytes.empty()) {
+        return;
+    }
+    Reader in(bytes.data(), bytes.data() + bytes.size());
+    PostingList positional;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        uint32_t position = 0;
+        for (int j = 0; j < postings.frequencies()[i]; ++j) {
+            position += static_cast<uint32_t>(in.varint());
+            positional.addPosition(postings.docs()[i], position);
         }
     }
- 
-    // Close the file
-    file.close();
-}
\ No newline at end of file
+    postings = std::move(positional);
+}
+
+// Function to decode the positions of a list loaded from a words file, which start at its savedPositions()
+void Index::readSavedPositions(std::string_view wordFile, PostingList &postings) {
+    if (postings.savedPositions() == 0 || postings.savedPositions() >= wordFile.size()) {
+        return;
+    }
+    readPositions(Reader(wordFile.data() + postings.savedPositions(), wordFile.data() + wordFile.size()).view(),
+                  postings);
+}
+
+// Function to write the header and payload of an index file
+void Index::writeFile(const std::string &filepath, Header header, const std::string &payload) {
+    header.payloadSize = payload.size();
+    header.checksum = IndexFormat::checksum(payload.data(), payload.size());
+
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "The file cannot open: " << filepath << std::endl;
+        return;
+    }
+    file << IndexFormat::encodeHeader(header);
+    file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+}
+
+// Function to read a whole index file into memory with a single read
+std::string Index::readFile(const std::string &filepath) {
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "The file cannot open: " << filepath << std::endl;
+        return "";
+    }
+
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&data[0], static_cast<std::streamsize>(data.size()));
+    return data;
+}
@@ -4,30 +4,50 @@
 #include <map>
 #include <set>
 #include <string>
-#include "AvlTree.h"
+#include "AVLTree.h"
+#include "HashMap.h"
 #include "DocumentParser.h"
+#include "IndexFormat.h"
 
 class Index
 {
 public:
     Index();
 
-    // Saving data to persistent storage
-    void saveWordData(std::string &filepath, AvlTree<std::string, std::map<std::string, int>> &wordTree);
-    void saveNameData(std::string &filepath, AvlTree<std::string, std::set<std::string>> &nameTree);
-    void saveDocumentData(std::string &filepath, AvlTree<std::string, document> &documentTree);
+    // Saving data to persistent storage, documentCount is the size of the DocumentTable the postings refer to.
+    // wordFile holds the words file loadWordData() read the tree from, if it did, for the positions in it.
+    void saveWordData(std::string &filepath, AvlTree<std::string, PostingList> &wordTree,
+                      uint32_t documentCount, std::string_view wordFile = {});
+    void saveNameData(std::string &filepath, HashMap<std::string, std::vector<uint32_t>> &nameTree,
+                      uint32_t documentCount);
+    void saveDocumentData(std::string &filepath, DocumentTable &documentTable);
 
-    // Loading data from persistent storage
-    void loadWordData(const std::string &filepath, AvlTree<std::string, std::map<std::string, int>> &wordTree);
-    void loadNameData(const std::string &filepath, AvlTree<std::string, std::set<std::string>> &nameTree);
-    void loadDocumentData(const std::string &filepath, AvlTree<std::string, document> &documentTree);
+    // Loading data from persistent storage. Given wordFile, loading words into an empty tree hands it the
+    // bytes of the file, and the lists only record where their positions are in them.
+    void loadWordData(const std::string &filepath, AvlTree<std::string, PostingList> &wordTree,
+                      std::string *wordFile = nullptr);
+    void loadNameData(const std::string &filepath, HashMap<std::string, std::vector<uint32_t>> &nameTree);
+    void loadDocumentData(const std::string &filepath, DocumentTable &documentTable);
 
-    void mergeData(AvlTree<std::string, std::map<std::string, int>> &tree,
+    // Gives a posting list read from a words file the positions stored after it, when there are any
+    static void readPositions(std::string_view bytes, PostingList &postings);
+
+    // Gives a list loadWordData() read from wordFile the positions at its savedPositions(), for the
+    // queries that need them
+    static void readSavedPositions(std::string_view wordFile, PostingList &postings);
+
+    void mergeData(AvlTree<std::string, PostingList> &tree,
                    const std::string &key,
-                   const std::map<std::string, int> &newData);
+                   const PostingList &newData);
 
 private:
     int documentCount;
+
+    // Writes header and payload of a binary index file
+    void writeFile(const std::string &filepath, IndexFormat::Header header, const std::string &payload);
+
+    // Reads a whole binary index file, returns an empty string when it cannot be opened
+    std::string readFile(const std::string &filepath);
 };
 
 #endif // INDEX_H
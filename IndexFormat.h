@@ -0,0 +1,303 @@
+#ifndef INDEXFORMAT_H
+#define INDEXFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// The vendored hash falls through its switch cases on purpose
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#include "util/hash.h"
+#pragma GCC diagnostic pop
+
+// Binary layout of the persisted index files. Every file starts with a fixed 48 byte header:
+//
+//   magic "SSIX" | version u32 | kind u32 | docCount u32 | entryCount u64 | payloadSize u64 | checksum u64
+//   | totalLength u64
+//
+// followed by the payload, whose MurmurHash3 is stored in the checksum field:
+//
+//   entryCount entries            layout depends on the kind (see Index.cpp)
+//   entryCount offsets u64        start of every entry in the payload
+//
+// Words files keep their terms apart from the postings, front-coded in blocks (see TermBlockReader),
+// so that the terms take less space and a lookup reads a few adjacent bytes instead of one entry per
+// probe:
+//
+//   entryCount posting lists      in term order
+//   blockCount term blocks        TERMS_PER_BLOCK terms each, the last one possibly fewer
+//   blockCount offsets u64        start of every term block in the payload
+//
+// A posting list ends with the positions of the term as a string, empty when the index was built
+// without them, so readers that only need the postings never decode the positions.
+//
+// Word and name entries are sorted by key so the offset table can be binary searched, and their
+// postings refer to documents by DocumentTable ID. docCount is the number of documents in the table
+// they were written with, every ID is below it. The entries of a documents file are in ID order, so
+// entry i is the document with ID i, and totalLength is the sum of their lengths in tokens (it is 0 in
+// the other files) so the average document length is known without reading every entry. Integers in the
+// header and the offset table are little-endian and fixed width. Inside the entries all integers are
+// LEB128 varints, strings are a varint length followed by the bytes, and the document IDs of a posting
+// list are stored as deltas from the previous ID.
+namespace IndexFormat
+{
+    const char MAGIC[4] = {'S', 'S', 'I', 'X'};
+    const uint32_t VERSION = 6;
+    const size_t HEADER_SIZE = 48;
+    const uint64_t CHECKSUM_SEED = 0x5353495855ULL;
+    const uint64_t TERMS_PER_BLOCK = 16;
+
+    // Which tree a file was written from
+    enum Kind : uint32_t
+    {
+        WORDS = 1,
+        NAMES = 2,
+        DOCUMENTS = 3
+    };
+
+    struct Header
+    {
+        uint32_t version = VERSION;
+        uint32_t kind = 0;
+        uint32_t docCount = 0;
+        uint64_t entryCount = 0;
+        uint64_t payloadSize = 0;
+        uint64_t checksum = 0;
+        uint64_t totalLength = 0;
+    };
+
+    // Appends encoded values to a byte buffer
+    class Writer
+    {
+    public:
+        explicit Writer(std::string &out) : out{out} {}
+
+        void fixed(uint64_t value, int bytes)
+        {
+            for (int i = 0; i < bytes; ++i)
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+        }
+
+        void varint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void str(std::string_view s)
+        {
+            varint(s.size());
+            out.append(s.data(), s.size());
+        }
+
+        size_t size() const { return out.size(); }
+
+    private:
+        std::string &out;
+    };
+
+    // Decodes values from a byte range, throwing when a value runs past the end of the range
+    class Reader
+    {
+    public:
+        Reader(const char *begin, const char *end) : pos{begin}, end{end} {}
+
+        uint64_t fixed(int bytes)
+        {
+            need(bytes);
+            uint64_t value = 0;
+            for (int i = 0; i < bytes; ++i)
+                value |= static_cast<uint64_t>(static_cast<unsigned char>(pos[i])) << (8 * i);
+            pos += bytes;
+            return value;
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                need(1);
+                unsigned char byte = static_cast<unsigned char>(*pos++);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (byte < 0x80)
+                    return value;
+            }
+            throw std::runtime_error("Corrupt index file: malformed varint");
+        }
+
+        std::string str()
+        {
+            return std::string(view());
+        }
+
+        // Like str(), but points into the underlying bytes instead of copying them
+        std::string_view view()
+        {
+            uint64_t length = varint();
+            need(length);
+            std::string_view s(pos, length);
+            pos += length;
+            return s;
+        }
+
+        const char *position() const { return pos; }
+        bool atEnd() const { return pos == end; }
+
+    private:
+        void need(uint64_t bytes) const
+        {
+            if (static_cast<uint64_t>(end - pos) < bytes)
+                throw std::runtime_error("Corrupt index file: unexpected end of data");
+        }
+
+        const char *pos;
+        const char *end;
+    };
+
+    // Decodes the terms of one block of a words file in order. The first term of a block is a string,
+    // so a binary search over the blocks can compare it in place. Every other term is the number of
+    // leading bytes it shares with the term before it followed by a string of the rest. Each term is
+    // followed by the payload offset of its posting list, for all but the first as the distance from
+    // the posting list of the term before.
+    class TermBlockReader
+    {
+    public:
+        // in is positioned at the start of a block holding the given number of terms
+        TermBlockReader(Reader in, uint64_t terms) : in{in}, left{terms} {}
+
+        // Moves to the next term of the block, returns false after the last one
+        bool next()
+        {
+            if (left == 0)
+                return false;
+
+            if (first)
+            {
+                current.assign(in.view());
+                offset = in.varint();
+                first = false;
+            }
+            else
+            {
+                uint64_t shared = in.varint();
+                if (shared > current.size())
+                    throw std::runtime_error("Corrupt index file: term shares more than the previous term");
+                std::string_view rest = in.view();
+                current.resize(shared);
+                current.append(rest.data(), rest.size());
+                offset += in.varint();
+            }
+            left--;
+            return true;
+        }
+
+        const std::string &term() const { return current; }
+        uint64_t postingsOffset() const { return offset; }
+
+    private:
+        Reader in;
+        uint64_t left;       // terms not read yet
+        bool first = true;   // next() has not been called yet
+        std::string current; // term next() moved to
+        uint64_t offset = 0; // payload offset of its posting list
+    };
+
+    // Number of term blocks of a words file
+    inline uint64_t blockCount(const Header &header)
+    {
+        return (header.entryCount + TERMS_PER_BLOCK - 1) / TERMS_PER_BLOCK;
+    }
+
+    // Number of terms in block b of a words file
+    inline uint64_t termsInBlock(const Header &header, uint64_t b)
+    {
+        uint64_t before = b * TERMS_PER_BLOCK;
+        return header.entryCount - before < TERMS_PER_BLOCK ? header.entryCount - before : TERMS_PER_BLOCK;
+    }
+
+    // Number of offsets in the table at the end of the payload: one per term block in a words file and
+    // one per entry in the others
+    inline uint64_t tableSize(const Header &header)
+    {
+        return header.kind == WORDS ? blockCount(header) : header.entryCount;
+    }
+
+    // Checks an offset into the payload read from the file
+    inline uint64_t payloadOffset(uint64_t offset, const Header &header)
+    {
+        if (offset >= header.payloadSize)
+            throw std::runtime_error("Corrupt index file: entry offset out of range");
+        return offset;
+    }
+
+    // MurmurHash3 of the payload bytes
+    inline uint64_t checksum(const char *data, size_t length)
+    {
+        meta::util::murmur_hash<8> hash(CHECKSUM_SEED);
+        hash(data, length);
+        return static_cast<std::size_t>(hash);
+    }
+
+    // Checks a document ID read from a posting list
+    inline uint32_t documentId(uint64_t id, const Header &header)
+    {
+        if (id >= header.docCount)
+            throw std::runtime_error("Corrupt index file: document ID out of range");
+        return static_cast<uint32_t>(id);
+    }
+
+    // Serializes a header into its fixed 48 byte form
+    inline std::string encodeHeader(const Header &header)
+    {
+        std::string bytes(MAGIC, sizeof(MAGIC));
+        Writer out(bytes);
+        out.fixed(header.version, 4);
+        out.fixed(header.kind, 4);
+        out.fixed(header.docCount, 4);
+        out.fixed(header.entryCount, 8);
+        out.fixed(header.payloadSize, 8);
+        out.fixed(header.checksum, 8);
+        out.fixed(header.totalLength, 8);
+        return bytes;
+    }
+
+    // Parses and validates the header at the start of a file of the given size
+    // Checking the checksum reads the whole payload, which read-only mapped access skips
+    inline Header decodeHeader(const char *data, size_t size, Kind expected, bool verifyChecksum = true)
+    {
+        if (size < HEADER_SIZE || std::string(data, sizeof(MAGIC)) != std::string(MAGIC, sizeof(MAGIC)))
+            throw std::runtime_error("Not a supersearch index file");
+
+        Reader in(data + sizeof(MAGIC), data + HEADER_SIZE);
+        Header header;
+        header.version = static_cast<uint32_t>(in.fixed(4));
+        header.kind = static_cast<uint32_t>(in.fixed(4));
+        header.docCount = static_cast<uint32_t>(in.fixed(4));
+        header.entryCount = in.fixed(8);
+        header.payloadSize = in.fixed(8);
+        header.checksum = in.fixed(8);
+        header.totalLength = in.fixed(8);
+
+        if (header.version != VERSION)
+            throw std::runtime_error("Unsupported index file version " + std::to_string(header.version));
+        if (header.kind != expected)
+            throw std::runtime_error("Index file holds a different kind of index");
+        if (header.payloadSize != size - HEADER_SIZE)
+            throw std::runtime_error("Corrupt index file: payload size does not match the header");
+        if (header.entryCount > header.payloadSize || tableSize(header) > header.payloadSize / 8)
+            throw std::runtime_error("Corrupt index file: offset table does not fit the payload");
+        if (verifyChecksum && header.checksum != checksum(data + HEADER_SIZE, header.payloadSize))
+            throw std::runtime_error("Corrupt index file: checksum mismatch");
+        return header;
+    }
+}
+
+#endif // INDEXFORMAT_H
@@ -0,0 +1,118 @@
+#include "Intersection.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Intersection
+{
+    size_t intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        if (na == 0 || nb == 0)
+            return 0;
+
+        // Keep the shorter list first
+        if (na > nb)
+        {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        if (nb / na >= GALLOP_RATIO)
+            return gallopIntersect(a, na, b, nb, out);
+        return simdIntersect(a, na, b, nb, out);
+    }
+
+    size_t mergeIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        size_t i = 0, j = 0, k = 0;
+        while (i < na && j < nb)
+        {
+            if (a[i] < b[j])
+                ++i;
+            else if (b[j] < a[i])
+                ++j;
+            else
+            {
+                out[k++] = a[i];
+                ++i;
+                ++j;
+            }
+        }
+        return k;
+    }
+
+    size_t gallopIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        size_t j = 0, k = 0;
+        for (size_t i = 0; i < na && j < nb; ++i)
+        {
+            j = gallop(b, nb, j, a[i]);
+            if (j < nb && b[j] == a[i])
+                out[k++] = a[i];
+        }
+        return k;
+    }
+
+    size_t simdIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        size_t i = 0, j = 0, k = 0;
+#ifdef __SSE2__
+        while (i + 4 <= na && j + 4 <= nb)
+        {
+            // Compare the block of a against all four rotations of the block of b
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+            __m128i match = _mm_cmpeq_epi32(va, vb);
+            match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39)));
+            match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)));
+            match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93)));
+
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(match));
+            for (int bit = 0; bit < 4; ++bit)
+            {
+                if (mask & (1 << bit))
+                    out[k++] = a[i + bit];
+            }
+
+            // Move past whichever block ends first, or both when they end on the same ID
+            uint32_t lastA = a[i + 3], lastB = b[j + 3];
+            if (lastA <= lastB)
+                i += 4;
+            if (lastB <= lastA)
+                j += 4;
+        }
+#endif
+        // The rest is shorter than a block on at least one side
+        return k + mergeIntersect(a + i, na - i, b + j, nb - j, out + k);
+    }
+
+    size_t subtract(uint32_t *a, size_t na, const uint32_t *b, size_t nb)
+    {
+        size_t j = 0, k = 0;
+        for (size_t i = 0; i < na; ++i)
+        {
+            j = gallop(b, nb, j, a[i]);
+            if (j == nb || b[j] != a[i])
+                a[k++] = a[i];
+        }
+        return k;
+    }
+
+    size_t gallop(const uint32_t *list, size_t n, size_t from, uint32_t target)
+    {
+        if (from >= n || list[from] >= target)
+            return from;
+
+        // Double the step until it passes the target, then binary search the last step
+        size_t low = from, step = 1;
+        while (low + step < n && list[low + step] < target)
+        {
+            low += step;
+            step *= 2;
+        }
+        size_t high = std::min(low + step, n);
+        return std::lower_bound(list + low + 1, list + high, target) - list;
+    }
+}
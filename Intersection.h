@@ -0,0 +1,34 @@
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels for intersecting and subtracting sorted lists of document IDs. Every list must be strictly
+// ascending. The output array needs room for as many IDs as the shorter input has and must not
+// overlap either input.
+namespace Intersection
+{
+    // Lists that differ in length by at least this factor are intersected by galloping search
+    const size_t GALLOP_RATIO = 32;
+
+    // Intersects two lists with the kernel that suits their lengths, returns the number of matches
+    size_t intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+    // Linear merge of two lists, the fallback kernel
+    size_t mergeIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+    // Looks up every ID of the short list a in the long list b by exponential then binary search
+    size_t gallopIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+    // Compares blocks of four IDs against each other with SSE2, falls back to mergeIntersect elsewhere
+    size_t simdIntersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+    // Removes every ID of b from a in place, returns the new length of a
+    size_t subtract(uint32_t *a, size_t na, const uint32_t *b, size_t nb);
+
+    // Returns the first position at or after from whose ID is not below target, or n if there is none
+    size_t gallop(const uint32_t *list, size_t n, size_t from, uint32_t target);
+}
+
+#endif // INTERSECTION_H
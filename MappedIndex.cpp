@@ -0,0 +1,284 @@
+#include "MappedIndex.h"
+#include "Index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using IndexFormat::Reader;
+
+// Destructor unmaps the files
+MappedIndex::~MappedIndex()
+{
+    close();
+}
+
+// open() maps all four files. If one of them fails, the ones already mapped are released again.
+bool MappedIndex::open(const std::string &wordsPath, const std::string &peoplePath,
+                       const std::string &orgsPath, const std::string &docsPath)
+{
+    close();
+    if (map(wordsPath, IndexFormat::WORDS, words) && map(peoplePath, IndexFormat::NAMES, people) &&
+        map(orgsPath, IndexFormat::NAMES, orgs) && map(docsPath, IndexFormat::DOCUMENTS, docs))
+    {
+        return true;
+    }
+    close();
+    return false;
+}
+
+void MappedIndex::close()
+{
+    unmap(words);
+    unmap(people);
+    unmap(orgs);
+    unmap(docs);
+}
+
+bool MappedIndex::isOpen() const
+{
+    return docs.data != nullptr;
+}
+
+// findWord() binary searches the term blocks by their first term, then decodes the one block the term
+// can be in
+bool MappedIndex::findWord(std::string_view term, PostingList &postings, bool withPositions) const
+{
+    uint64_t block = blockAfter(term);
+    if (block == 0)
+        return false; // The term is less than the first one
+
+    bool found = false;
+    scanTerms(block - 1, [&](const std::string &candidate, Reader &in) {
+        if (candidate < term)
+            return true;
+        if (candidate == term)
+        {
+            readWordPostings(in, postings, withPositions);
+            found = true;
+        }
+        return false;
+    });
+    return found;
+}
+
+// findWordsWithPrefix() starts in the block the first term not less than the prefix is in and reads
+// terms from there while they start with it, since those terms are stored next to each other
+bool MappedIndex::findWordsWithPrefix(std::string_view prefix,
+                                      std::vector<std::pair<std::string, PostingList>> &entries) const
+{
+    size_t found = entries.size();
+    uint64_t block = blockAfter(prefix);
+    scanTerms(block == 0 ? 0 : block - 1, [&](const std::string &term, Reader &in) {
+        if (term < prefix)
+            return true;
+        if (term.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        entries.emplace_back(term, PostingList());
+        readWordPostings(in, entries.back().second);
+        return true;
+    });
+    return entries.size() > found;
+}
+
+uint64_t MappedIndex::blockAfter(std::string_view term) const
+{
+    uint64_t low = 0, high = IndexFormat::blockCount(words.header);
+    while (low < high)
+    {
+        uint64_t mid = low + (high - low) / 2;
+        if (term < entryAt(words, mid).view())
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+template <typename Visitor>
+void MappedIndex::scanTerms(uint64_t block, Visitor visit) const
+{
+    const char *payload = words.data + IndexFormat::HEADER_SIZE;
+    const char *blockTable = words.data + words.size - 8 * IndexFormat::blockCount(words.header);
+    for (; block < IndexFormat::blockCount(words.header); ++block)
+    {
+        Reader start(payload + offsetAt(words, blockTable, block), blockTable);
+        IndexFormat::TermBlockReader terms(start, IndexFormat::termsInBlock(words.header, block));
+        while (terms.next())
+        {
+            Reader in(payload + IndexFormat::payloadOffset(terms.postingsOffset(), words.header), blockTable);
+            if (!visit(terms.term(), in))
+                return;
+        }
+    }
+}
+
+void MappedIndex::readWordPostings(Reader &in, PostingList &postings, bool withPositions) const
+{
+    uint64_t count = in.varint();
+    uint64_t id = 0;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        id += in.varint();
+        int frequency = static_cast<int>(in.varint());
+        postings.add(IndexFormat::documentId(id, words.header), frequency);
+    }
+    // The positions follow the postings, so a lookup without them never touches their pages
+    if (withPositions)
+        Index::readPositions(in.view(), postings);
+}
+
+bool MappedIndex::findPerson(std::string_view name, std::vector<uint32_t> &postings) const
+{
+    return findName(people, name, postings);
+}
+
+bool MappedIndex::findOrganization(std::string_view name, std::vector<uint32_t> &postings) const
+{
+    return findName(orgs, name, postings);
+}
+
+// findDocument() jumps straight to the entry of the ID, documents are stored in ID order
+bool MappedIndex::findDocument(uint32_t id, document &doc) const
+{
+    if (id >= docs.header.entryCount)
+        return false;
+
+    Reader in = entryAt(docs, id);
+    in.view();   // Skip the UUID
+    in.varint(); // and the length
+
+    doc.title = in.str();
+    doc.identifier = in.str();
+    doc.publicationDate = in.str();
+    doc.authorName = in.str();
+    doc.content = in.str();
+    return true;
+}
+
+uint32_t MappedIndex::documentCount() const
+{
+    return docs.header.docCount;
+}
+
+uint64_t MappedIndex::totalLength() const
+{
+    return docs.header.totalLength;
+}
+
+// documentLength() decodes only the UUID and length at the start of the entry
+uint32_t MappedIndex::documentLength(uint32_t id) const
+{
+    if (id >= docs.header.entryCount)
+        return 0;
+
+    Reader in = entryAt(docs, id);
+    in.view();
+    return static_cast<uint32_t>(in.varint());
+}
+
+// map() opens and maps a file and checks its header. Errors are reported like a missing persistence
+// file in Index, by printing a message and leaving the section unmapped, a header that cannot be used
+// included.
+bool MappedIndex::map(const std::string &path, IndexFormat::Kind kind, Section &section)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "The file cannot open: " << path << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        std::cerr << "The file cannot open: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "The file cannot be mapped: " << path << std::endl;
+        return false;
+    }
+
+    try
+    {
+        section.header = IndexFormat::decodeHeader(static_cast<const char *>(data), size, kind, false);
+    }
+    catch (const std::runtime_error &error)
+    {
+        std::cerr << "The file cannot be used: " << path << ": " << error.what() << std::endl;
+        munmap(data, size);
+        return false;
+    }
+    section.data = static_cast<const char *>(data);
+    section.size = size;
+    return true;
+}
+
+void MappedIndex::unmap(Section &section)
+{
+    if (section.data != nullptr)
+        munmap(const_cast<char *>(section.data), section.size);
+    section = Section{};
+}
+
+// findEntry() binary searches the entry offset table. Every probe decodes just the key of one entry
+// and compares it in place.
+Reader MappedIndex::findEntry(const Section &section, std::string_view key) const
+{
+    const char *end = section.data + section.size;
+
+    uint64_t low = 0, high = section.header.entryCount;
+    while (low < high)
+    {
+        uint64_t mid = low + (high - low) / 2;
+        Reader in = entryAt(section, mid);
+        std::string_view probe = in.view();
+        if (probe < key)
+            low = mid + 1;
+        else if (key < probe)
+            high = mid;
+        else
+            return in;
+    }
+    return Reader(end, end);
+}
+
+Reader MappedIndex::entryAt(const Section &section, uint64_t i) const
+{
+    const char *payload = section.data + IndexFormat::HEADER_SIZE;
+    const char *table = section.data + section.size - 8 * IndexFormat::tableSize(section.header);
+    return Reader(payload + offsetAt(section, table, i), table);
+}
+
+uint64_t MappedIndex::offsetAt(const Section &section, const char *table, uint64_t i) const
+{
+    return IndexFormat::payloadOffset(Reader(table + 8 * i, table + 8 * (i + 1)).fixed(8), section.header);
+}
+
+bool MappedIndex::findName(const Section &section, std::string_view name, std::vector<uint32_t> &postings) const
+{
+    Reader in = findEntry(section, name);
+    if (in.atEnd())
+        return false;
+
+    // Decode the document ID deltas
+    uint64_t count = in.varint();
+    uint64_t id = 0;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        id += in.varint();
+        postings.push_back(IndexFormat::documentId(id, section.header));
+    }
+    return true;
+}
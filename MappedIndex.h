@@ -0,0 +1,95 @@
+#ifndef MAPPEDINDEX_H
+#define MAPPEDINDEX_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "IndexFormat.h"
+#include "PostingList.h"
+#include "document.h"
+
+// Read-only view of the persisted binary index files. The files are mmap'ed and every lookup binary
+// searches the entry offset table (or indexes it directly for documents) and decodes only the entry it
+// needs, so no AvlTree is built and the cost of a lookup does not depend on how large the index is.
+// Words are found by binary searching the term blocks and decoding the one block the term can be in.
+// Checksums are not verified since that would read every page of the files.
+class MappedIndex
+{
+public:
+    MappedIndex() = default;
+    ~MappedIndex();
+
+    MappedIndex(const MappedIndex &) = delete;
+    MappedIndex &operator=(const MappedIndex &) = delete;
+
+    // Maps the four index files, returns false and maps nothing when one of them cannot be used
+    bool open(const std::string &wordsPath, const std::string &peoplePath,
+              const std::string &orgsPath, const std::string &docsPath);
+
+    // Unmaps all files
+    void close();
+
+    bool isOpen() const;
+
+    // Each lookup fills the result and returns true when the key is in the index. findWord() reads the
+    // positions of the term as well when asked to and the index has them.
+    bool findWord(std::string_view term, PostingList &postings, bool withPositions = false) const;
+    bool findPerson(std::string_view name, std::vector<uint32_t> &postings) const;
+    bool findOrganization(std::string_view name, std::vector<uint32_t> &postings) const;
+
+    // Appends every term that starts with prefix to entries, in key order, together with its postings.
+    // Returns true when there is at least one.
+    bool findWordsWithPrefix(std::string_view prefix, std::vector<std::pair<std::string, PostingList>> &entries) const;
+
+    // Fills doc with the document of an ID, returns false for unknown IDs
+    bool findDocument(uint32_t id, document &doc) const;
+
+    // Collection statistics for scoring, read from the documents file
+    uint32_t documentCount() const;
+    uint64_t totalLength() const;
+    uint32_t documentLength(uint32_t id) const; // 0 for unknown IDs
+
+private:
+    // One mapped index file
+    struct Section
+    {
+        const char *data = nullptr; // start of the mapping
+        size_t size = 0;            // length of the mapping
+        IndexFormat::Header header;
+    };
+
+    Section words, people, orgs, docs;
+
+    bool map(const std::string &path, IndexFormat::Kind kind, Section &section);
+    void unmap(Section &section);
+
+    // Returns a reader positioned right after the key of the entry with the given key, or a reader at
+    // the end of the payload when the key is not present
+    IndexFormat::Reader findEntry(const Section &section, std::string_view key) const;
+
+    // Returns a reader positioned at the start of entry i, or of term block i in the words file
+    IndexFormat::Reader entryAt(const Section &section, uint64_t i) const;
+
+    // Returns the first term block whose first term is greater than term
+    uint64_t blockAfter(std::string_view term) const;
+
+    // Calls visit(term, reader at its posting list) for the terms from the start of the given block
+    // on, in order, until visit returns false
+    template <typename Visitor>
+    void scanTerms(uint64_t block, Visitor visit) const;
+
+    // Decodes the (document ID delta, frequency) pairs of a word entry
+    void readWordPostings(IndexFormat::Reader &in, PostingList &postings, bool withPositions = false) const;
+
+    // Returns the payload offset stored at position i of the offset table starting at table
+    uint64_t offsetAt(const Section &section, const char *table, uint64_t i) const;
+
+    bool findName(const Section &section, std::string_view name, std::vector<uint32_t> &postings) const;
+};
+
+#endif // MAPPEDINDEX_H
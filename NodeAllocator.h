@@ -0,0 +1,99 @@
+#ifndef NODEALLOCATOR_H
+#define NODEALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocator policies for the nodes of AvlTree. A policy is a class template over the node type that
+// provides create(args...), destroy(node) and clear(). releasesInBulk tells the tree whether clear()
+// returns the memory of every node at once, so that makeEmpty() only has to walk the tree when the
+// nodes have destructors to run.
+
+// HeapAllocator gives every node its own new/delete, which is what AvlTree did originally.
+template <typename T>
+class HeapAllocator
+{
+public:
+    static const bool releasesInBulk = false;
+
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *node)
+    {
+        delete node;
+    }
+
+    void clear() {}
+};
+
+// SlabAllocator carves nodes out of large contiguous blocks. Destroyed nodes go onto a free list and
+// are handed out again before the current block is used up, and clear() drops all blocks at once.
+template <typename T>
+class SlabAllocator
+{
+public:
+    static const bool releasesInBulk = true;
+    static const std::size_t NodesPerBlock = 1024;
+
+    SlabAllocator() : freeList{nullptr}, used{NodesPerBlock} {}
+
+    // Every tree owns its own arena, so copies start out empty
+    SlabAllocator(const SlabAllocator &) : SlabAllocator() {}
+    SlabAllocator &operator=(const SlabAllocator &) { return *this; }
+
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        Slot *slot = freeList;
+        if (slot != nullptr)
+        {
+            freeList = slot->next;
+        }
+        else
+        {
+            if (used == NodesPerBlock)
+            {
+                blocks.emplace_back(new Slot[NodesPerBlock]);
+                used = 0;
+            }
+            slot = &blocks.back()[used++];
+        }
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *node)
+    {
+        node->~T();
+        Slot *slot = reinterpret_cast<Slot *>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    // Releases every block. Nodes still alive are not destroyed, the tree has to do that first.
+    void clear()
+    {
+        blocks.clear();
+        freeList = nullptr;
+        used = NodesPerBlock;
+    }
+
+private:
+    union Slot
+    {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> blocks; // Blocks of NodesPerBlock slots each
+    Slot *freeList;                              // Slots of destroyed nodes, ready for reuse
+    std::size_t used;                            // Slots handed out from the last block
+};
+
+#endif // NODEALLOCATOR_H
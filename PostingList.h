@@ -0,0 +1,319 @@
+#ifndef POSTINGLIST_H
+#define POSTINGLIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// PostingList holds the documents a term occurs in, sorted by document ID, together with how often the
+// term occurs in each of them. IDs and counts live in two parallel arrays so that intersections can
+// scan the IDs alone. A list built with addPosition() also keeps the positions of the term in every
+// document, in two more arrays behind a pointer that only phrase and proximity queries read. A list
+// loaded from a words file keeps only where its positions are in the file, for those queries to decode.
+class PostingList
+{
+public:
+    // Postings per block of blockMaxima()
+    static const size_t BLOCK_SIZE = 64;
+
+    PostingList() = default;
+
+    // Builds a list from (document ID, count) pairs in any order
+    PostingList(std::initializer_list<std::pair<uint32_t, int>> postings)
+    {
+        for (const auto &posting : postings)
+            add(posting.first, posting.second);
+    }
+
+    PostingList(const PostingList &other)
+        : ids{other.ids}, counts{other.counts},
+          located{other.located ? std::make_unique<Positions>(*other.located) : nullptr}, saved{other.saved},
+          maxima{other.maxima}
+    {
+    }
+    PostingList(PostingList &&) = default;
+
+    PostingList &operator=(const PostingList &other)
+    {
+        if (this != &other)
+            *this = PostingList(other);
+        return *this;
+    }
+    PostingList &operator=(PostingList &&) = default;
+
+    // Adds count occurrences in a document. Documents are indexed in ID order, so this is almost
+    // always an append or an increment of the last posting. The list no longer has positions after.
+    void add(uint32_t doc, int count = 1)
+    {
+        dropPositions();
+        maxima.clear();
+        if (ids.empty() || ids.back() < doc)
+        {
+            ids.push_back(doc);
+            counts.push_back(count);
+            return;
+        }
+
+        auto pos = std::lower_bound(ids.begin(), ids.end(), doc);
+        size_t i = pos - ids.begin();
+        if (*pos == doc)
+        {
+            counts[i] += count;
+        }
+        else
+        {
+            ids.insert(pos, doc);
+            counts.insert(counts.begin() + i, count);
+        }
+    }
+
+    // Adds one occurrence at a position of a document, keeping the positions of every posting. A list
+    // is built either with this or with add(), not both.
+    void addPosition(uint32_t doc, uint32_t position)
+    {
+        maxima.clear();
+        saved = 0;
+        if (!located)
+        {
+            located = std::make_unique<Positions>();
+            located->starts.push_back(0);
+        }
+        std::vector<uint32_t> &starts = located->starts, &positions = located->positions;
+        if (ids.empty() || ids.back() < doc)
+        {
+            ids.push_back(doc);
+            counts.push_back(1);
+            positions.push_back(position);
+            starts.push_back(static_cast<uint32_t>(positions.size()));
+            return;
+        }
+        if (ids.back() == doc && positions.back() <= position)
+        {
+            counts.back()++;
+            positions.push_back(position);
+            starts.back()++;
+            return;
+        }
+
+        // An earlier document, or an earlier position of the last one
+        auto pos = std::lower_bound(ids.begin(), ids.end(), doc);
+        size_t i = pos - ids.begin();
+        if (*pos != doc)
+        {
+            ids.insert(pos, doc);
+            counts.insert(counts.begin() + i, 0);
+            starts.insert(starts.begin() + i + 1, starts[i]);
+        }
+        counts[i]++;
+        auto last = positions.begin() + starts[i + 1];
+        positions.insert(std::upper_bound(positions.begin() + starts[i], last, position), position);
+        for (size_t j = i + 1; j < starts.size(); ++j)
+            starts[j]++;
+    }
+
+    // Adds all postings of another list, summing the counts of documents in both. The positions are
+    // kept when both lists have them (or this one is empty) and withPositions is true.
+    void merge(const PostingList &other, bool withPositions = true)
+    {
+        if (other.ids.empty())
+            return;
+        maxima.clear();
+        saved = 0;
+        bool keepPositions = withPositions && other.hasPositions() && (ids.empty() || hasPositions());
+        if (!keepPositions)
+        {
+            dropPositions();
+        }
+        else if (!located)
+        {
+            located = std::make_unique<Positions>();
+            located->starts.push_back(0);
+        }
+        if (ids.empty() || ids.back() < other.ids.front())
+        {
+            ids.insert(ids.end(), other.ids.begin(), other.ids.end());
+            counts.insert(counts.end(), other.counts.begin(), other.counts.end());
+            if (keepPositions)
+            {
+                std::vector<uint32_t> &positions = located->positions;
+                uint32_t shift = static_cast<uint32_t>(positions.size());
+                for (size_t j = 1; j < other.located->starts.size(); ++j)
+                    located->starts.push_back(other.located->starts[j] + shift);
+                positions.insert(positions.end(), other.located->positions.begin(), other.located->positions.end());
+            }
+            return;
+        }
+
+        // The lists interleave, so merge them into new arrays in one pass over both
+        std::vector<uint32_t> mergedIds;
+        std::vector<int> mergedCounts;
+        std::vector<uint32_t> mergedStarts, mergedPositions;
+        mergedIds.reserve(ids.size() + other.ids.size());
+        mergedCounts.reserve(ids.size() + other.ids.size());
+        if (keepPositions)
+        {
+            mergedStarts.reserve(ids.size() + other.ids.size() + 1);
+            mergedStarts.push_back(0);
+            mergedPositions.reserve(located->positions.size() + other.located->positions.size());
+        }
+        auto takePositions = [&mergedStarts, &mergedPositions](const PostingList &list, size_t k)
+        {
+            size_t middle = mergedPositions.size();
+            const Positions &from = *list.located;
+            mergedPositions.insert(mergedPositions.end(), from.positions.begin() + from.starts[k],
+                                   from.positions.begin() + from.starts[k + 1]);
+            std::inplace_merge(mergedPositions.begin() + mergedStarts.back(), mergedPositions.begin() + middle,
+                               mergedPositions.end());
+        };
+        size_t i = 0, j = 0;
+        while (i < ids.size() || j < other.ids.size())
+        {
+            if (j == other.ids.size() || (i < ids.size() && ids[i] < other.ids[j]))
+            {
+                mergedIds.push_back(ids[i]);
+                mergedCounts.push_back(counts[i]);
+                if (keepPositions)
+                    takePositions(*this, i);
+                i++;
+            }
+            else if (i == ids.size() || other.ids[j] < ids[i])
+            {
+                mergedIds.push_back(other.ids[j]);
+                mergedCounts.push_back(other.counts[j]);
+                if (keepPositions)
+                    takePositions(other, j);
+                j++;
+            }
+            else
+            {
+                mergedIds.push_back(ids[i]);
+                mergedCounts.push_back(counts[i] + other.counts[j]);
+                if (keepPositions)
+                {
+                    takePositions(*this, i);
+                    takePositions(other, j);
+                }
+                i++;
+                j++;
+            }
+            if (keepPositions)
+                mergedStarts.push_back(static_cast<uint32_t>(mergedPositions.size()));
+        }
+        ids.swap(mergedIds);
+        counts.swap(mergedCounts);
+        if (keepPositions)
+        {
+            located->starts.swap(mergedStarts);
+            located->positions.swap(mergedPositions);
+        }
+    }
+
+    // Replaces every document ID by newId[ID]. A mapping that keeps the IDs in order is applied in
+    // place, otherwise the list is rebuilt, which sorts it and combines documents given the same ID.
+    void renumber(const std::vector<uint32_t> &newId)
+    {
+        bool ascending = true;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            ids[i] = newId[ids[i]];
+            ascending = ascending && (i == 0 || ids[i - 1] < ids[i]);
+        }
+        if (ascending)
+            return;
+
+        PostingList rebuilt;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (!hasPositions())
+            {
+                rebuilt.add(ids[i], counts[i]);
+                continue;
+            }
+            for (auto range = positionsAt(i); range.first != range.second; ++range.first)
+                rebuilt.addPosition(ids[i], *range.first);
+        }
+        *this = std::move(rebuilt);
+    }
+
+    // Returns the count of a document, 0 when the term does not occur in it
+    int count(uint32_t doc) const
+    {
+        auto pos = std::lower_bound(ids.begin(), ids.end(), doc);
+        return pos != ids.end() && *pos == doc ? counts[pos - ids.begin()] : 0;
+    }
+
+    const std::vector<uint32_t> &docs() const { return ids; }
+    const std::vector<int> &frequencies() const { return counts; }
+
+    // The highest count of every BLOCK_SIZE postings in order, the last block possibly shorter. A score
+    // that grows with the count is bounded by them, which lets top-k queries skip whole blocks. They
+    // are worked out on the first call after the list changed and kept with it.
+    const std::vector<int> &blockMaxima() const
+    {
+        if (maxima.size() != (ids.size() + BLOCK_SIZE - 1) / BLOCK_SIZE)
+        {
+            maxima.clear();
+            for (size_t i = 0; i < counts.size(); i += BLOCK_SIZE)
+                maxima.push_back(*std::max_element(counts.begin() + i,
+                                                   counts.begin() + std::min(i + BLOCK_SIZE, counts.size())));
+        }
+        return maxima;
+    }
+
+    // The highest count of the list, 0 when it is empty
+    int maxFrequency() const
+    {
+        const std::vector<int> &blocks = blockMaxima();
+        return blocks.empty() ? 0 : *std::max_element(blocks.begin(), blocks.end());
+    }
+
+    bool hasPositions() const { return located != nullptr; }
+
+    // Where the positions of a list loaded from a words file start in that file, 0 when it was loaded
+    // without them or they have been decoded since (see Index::readSavedPositions)
+    uint64_t savedPositions() const { return saved; }
+    void setSavedPositions(uint64_t offset) { saved = offset; }
+
+    // The positions of the term in the document of posting i, ascending. Only for a list with positions.
+    std::pair<const uint32_t *, const uint32_t *> positionsAt(size_t i) const
+    {
+        return {located->positions.data() + located->starts[i], located->positions.data() + located->starts[i + 1]};
+    }
+
+    void dropPositions()
+    {
+        saved = 0;
+        located.reset();
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+
+    bool operator==(const PostingList &other) const
+    {
+        return ids == other.ids && counts == other.counts && saved == other.saved &&
+               (located && other.located ? located->starts == other.located->starts &&
+                                               located->positions == other.located->positions
+                                         : located == other.located);
+    }
+
+private:
+    struct Positions
+    {
+        std::vector<uint32_t> starts;    // start of the positions of every posting in positions, plus the
+                                         // end of the last one
+        std::vector<uint32_t> positions; // term positions of every posting, one run per posting
+    };
+
+    std::vector<uint32_t> ids;           // document IDs in ascending order
+    std::vector<int> counts;             // occurrences of the term in the document at the same position
+    std::unique_ptr<Positions> located;  // null for a list without positions
+    uint64_t saved = 0;                  // savedPositions()
+    mutable std::vector<int> maxima;     // blockMaxima(), emptied by every change to the counts
+};
+
+#endif // POSTINGLIST_H
@@ -1,190 +1,779 @@
 #include "Query.h"
-#include <sstream>
+#include "Index.h"
+#include "Intersection.h"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <limits>
 
-std::vector<std::pair<std::string, int>> Query::parseQuery(const std::string &query,
-                                                           AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                                                           AvlTree<std::string, std::set<std::string>> &people,
-                                                           AvlTree<std::string, std::set<std::string>> &orgs,
-                                                           AvlTree<std::string, std::string> &stopWords)
+namespace
 {
+    // An AND or OR without operands, which matches nothing
+    bool isEmpty(const Query::Expression &expression)
+    {
+        return expression.kind != Query::Expression::WORD && expression.kind != Query::Expression::NOT &&
+               expression.operands.empty();
+    }
+
+    // Adds an operand to an AND or OR, leaving out empty ones and lifting the operands of a nested
+    // expression of the same kind, so that the planner can order all of them together
+    void addOperand(Query::Expression &parent, Query::Expression &&operand)
+    {
+        if (isEmpty(operand))
+            return;
+        if (operand.kind == parent.kind)
+        {
+            for (auto &nested : operand.operands)
+                parent.operands.push_back(std::move(nested));
+            return;
+        }
+        parent.operands.push_back(std::move(operand));
+    }
+
+    // An AND or OR of a single operand is that operand
+    Query::Expression simplify(Query::Expression &&expression)
+    {
+        if (expression.operands.size() == 1)
+            return std::move(expression.operands.front());
+        return std::move(expression);
+    }
+
+    // Marks a cursor that is past its last posting, no document has this ID
+    const uint32_t END = std::numeric_limits<uint32_t>::max();
 
-    std::map<std::string, int> finalMap;
-    std::set<std::string> exclusionSet;
+    // Where rankTopK() is in the postings of one operand, with the most the operand adds to the score
+    // of a document in each block of BLOCK_SIZE postings and in the whole list
+    struct Cursor
+    {
+        Cursor(const uint32_t *docs, const int *counts, size_t size) : docs{docs}, counts{counts}, size{size} {}
+
+        const uint32_t *docs;
+        const int *counts; // nullptr when the operand occurs once in each document
+        size_t size;
+        size_t at = 0;                   // next posting
+        size_t block = 0;                // block of the next posting or a later one, see rankTopK()
+        std::vector<double> blockBounds; // bound of every block
+        double bound = 0;                // bound of the list
+
+        uint32_t doc() const { return at < size ? docs[at] : END; }
+        uint32_t lastOf(size_t b) const { return docs[std::min((b + 1) * PostingList::BLOCK_SIZE, size) - 1]; }
+        void seek(uint32_t target) { at = Intersection::gallop(docs, size, at, target); }
+    };
+}
 
-    std::istringstream queryStream(query);
-    std::string word;
-    while (queryStream >> word)
+Query::Expression Query::analyzeQuery(const std::string &query, const StopWordSet &stopWords)
+{
+    // Split the query into words and the parentheses around them. A '-' in front of a word or a group
+    // is a token of its own, the short form of NOT. A phrase is one token that keeps its opening quote.
+    std::vector<std::string> tokens;
+    std::string token;
+    auto endToken = [&tokens, &token]()
+    {
+        if (!token.empty())
+            tokens.push_back(std::move(token));
+        token.clear();
+    };
+    bool inPhrase = false;
+    for (char c : query)
     {
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower); // Convert word to lowercase
-        if (word.find("org:") == 0)
+        if (c == '"')
         {
-            parseAndProcessOrgs(word.substr(4), orgs, finalMap);
+            endToken();
+            if (!inPhrase)
+                token = "\"";
+            inPhrase = !inPhrase;
         }
-        else if (word.find("person:") == 0)
+        else if (inPhrase)
         {
-            parseAndProcessPeople(word.substr(7), people, finalMap);
+            token += c;
         }
-        else if (!word.empty() && word[0] != '-')
+        else if (std::isspace(static_cast<unsigned char>(c)))
         {
-            parseAndProcessTerms(word, wordTree, finalMap);
+            endToken();
         }
-        else if (!word.empty())
+        else if (c == '(' || c == ')')
+        {
+            endToken();
+            tokens.emplace_back(1, c);
+        }
+        else if (c == '-' && token.empty())
+        {
+            tokens.emplace_back("-");
+        }
+        else
         {
-            exclusionSet.insert(word.substr(1));
+            token += c;
         }
     }
-    excludeTerms(exclusionSet, finalMap);
-    return rankResults(finalMap);
+    endToken();
+
+    // A ')' without a matching '(' ends parseOr() early, so it is skipped and parsing goes on after it
+    Expression all;
+    size_t pos = 0;
+    while (pos < tokens.size())
+    {
+        addOperand(all, parseOr(tokens, pos, stopWords));
+        if (pos < tokens.size())
+            ++pos;
+    }
+    return simplify(std::move(all));
 }
 
-void Query::parseAndProcessTerms(const std::string &term,
-                                 AvlTree<std::string, std::map<std::string, int>> &wordTree,
-                                 std::map<std::string, int> &finalMap)
+Query::Expression Query::parseOr(const std::vector<std::string> &tokens, size_t &pos, const StopWordSet &stopWords)
 {
-    // Check if the term exists in the wordTree
-    if (wordTree.contains(term))
+    Expression either;
+    either.kind = Expression::OR;
+    addOperand(either, parseAnd(tokens, pos, stopWords));
+    while (pos < tokens.size() && tokens[pos] == "OR")
     {
-        // Retrieve the document-frequency map for the term
-        std::map<std::string, int> docs = wordTree.getValues(term);
+        ++pos;
+        addOperand(either, parseAnd(tokens, pos, stopWords));
+    }
+    return simplify(std::move(either));
+}
 
-        // If the finalMap is empty, initialize it with the current term's documents
-        if (finalMap.empty())
+Query::Expression Query::parseAnd(const std::vector<std::string> &tokens, size_t &pos, const StopWordSet &stopWords)
+{
+    // Words next to each other have to match together, whether or not AND stands between them
+    Expression all;
+    while (pos < tokens.size() && tokens[pos] != ")" && tokens[pos] != "OR")
+    {
+        if (tokens[pos] == "AND")
         {
-            finalMap = docs;
+            ++pos;
+            continue;
         }
-        else
+        addOperand(all, parseNear(tokens, pos, stopWords));
+    }
+    return simplify(std::move(all));
+}
+
+Query::Expression Query::parseNear(const std::vector<std::string> &tokens, size_t &pos, const StopWordSet &stopWords)
+{
+    // NEAR/k takes the distance from the operator itself, so "NEAR/3" is one token
+    auto nearDistance = [](const std::string &token, uint32_t &distance)
+    {
+        const std::string op = "NEAR/";
+        if (token.size() <= op.size() || token.compare(0, op.size(), op) != 0 ||
+            !std::all_of(token.begin() + op.size(), token.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+            return false;
+        distance = static_cast<uint32_t>(std::stoul(token.substr(op.size())));
+        return true;
+    };
+
+    Expression left = parseUnary(tokens, pos, stopWords);
+    uint32_t distance = 0;
+    while (pos < tokens.size() && nearDistance(tokens[pos], distance))
+    {
+        ++pos;
+        if (pos == tokens.size() || tokens[pos] == ")" || tokens[pos] == "OR" || tokens[pos] == "AND")
+            break;
+        Expression right = parseUnary(tokens, pos, stopWords);
+        auto isTerm = [](const Expression &e) { return e.kind == Expression::WORD && e.word.kind == Word::TERM; };
+        if (isTerm(left) && isTerm(right))
         {
-            // If the finalMap is not empty, retain only those documents that also appear for the current term
-            for (auto iter = finalMap.begin(); iter != finalMap.end();)
-            {
-                if (docs.find(iter->first) == docs.end())
-                {
-                    // If the document is not present for the current term, remove it from finalMap
-                    iter = finalMap.erase(iter);
-                }
-                else
-                {
-                    // If the document is present, update the frequency count by adding the current term's frequency
-                    iter->second += docs[iter->first];
-                    ++iter;
-                }
-            }
+            Expression near;
+            near.kind = Expression::NEAR;
+            near.distance = distance;
+            near.operands.push_back(std::move(left));
+            near.operands.push_back(std::move(right));
+            left = std::move(near);
+            continue;
         }
+        // Only two terms have positions to compare, anything else has to match as a whole
+        Expression all;
+        addOperand(all, std::move(left));
+        addOperand(all, std::move(right));
+        left = simplify(std::move(all));
+    }
+    return left;
+}
+
+Query::Expression Query::parseUnary(const std::vector<std::string> &tokens, size_t &pos, const StopWordSet &stopWords)
+{
+    const std::string &token = tokens[pos++];
+    if (token == "NOT" || token == "-")
+    {
+        if (pos == tokens.size() || tokens[pos] == ")" || tokens[pos] == "OR" || tokens[pos] == "AND")
+            return Expression(); // Nothing to negate
+
+        Expression operand = parseUnary(tokens, pos, stopWords);
+        if (isEmpty(operand))
+            return operand;
+        if (operand.kind == Expression::NOT)
+            return std::move(operand.operands.front()); // Two negations cancel out
+        Expression negation;
+        negation.kind = Expression::NOT;
+        negation.operands.push_back(std::move(operand));
+        return negation;
+    }
+    if (token[0] == '"')
+        return parsePhrase(std::string_view(token).substr(1), stopWords);
+    if (token == "(")
+    {
+        Expression group = parseOr(tokens, pos, stopWords);
+        if (pos < tokens.size() && tokens[pos] == ")")
+            ++pos;
+        return group;
+    }
+    return parseWord(token, stopWords);
+}
+
+Query::Expression Query::parseWord(std::string word, const StopWordSet &stopWords)
+{
+    Expression expression;
+    std::transform(word.begin(), word.end(), word.begin(), ::tolower); // Convert word to lowercase
+    std::string text;
+    if (word.find("org:") == 0)
+    {
+        expression.word = {Word::ORGANIZATION, word.substr(4)};
+    }
+    else if (word.find("person:") == 0)
+    {
+        expression.word = {Word::PERSON, word.substr(7)};
     }
+    else if (word.size() > 1 && word.back() == '*')
+    {
+        // A prefix is matched against stems, so it is cleaned but not stemmed itself
+        if (!analyzer.normalize(std::string_view(word).substr(0, word.size() - 1), text))
+            return expression;
+        expression.word = {Word::PREFIX, text};
+    }
+    else
+    {
+        // Stop words are not indexed, so they do not narrow the results
+        if (!analyzer.analyzeWord(word, stopWords, text))
+            return expression;
+        expression.word = {Word::TERM, text};
+    }
+    expression.kind = Expression::WORD;
+    return expression;
 }
 
-void Query::parseAndProcessOrgs(const std::string &org,
-                                AvlTree<std::string, std::set<std::string>> &orgs,
-                                std::map<std::string, int> &finalMap)
+Query::Expression Query::parsePhrase(std::string_view text, const StopWordSet &stopWords)
 {
-    // Check if the organization exists in the orgs tree
-    if (orgs.contains(org))
+    // The phrase is analyzed like a document, so its terms line up with the indexed positions
+    Expression phrase;
+    analyzer.analyze(text, stopWords, [&phrase](std::string &term)
     {
-        // Retrieve the set of documents associated with the organization
-        std::set<std::string> docs = orgs.getValues(org);
+        Expression word;
+        word.kind = Expression::WORD;
+        word.word = {Word::TERM, term};
+        phrase.operands.push_back(std::move(word));
+    });
+    if (phrase.operands.size() > 1)
+        phrase.kind = Expression::PHRASE;
+    return simplify(std::move(phrase));
+}
+
+template <typename Dictionary>
+std::vector<std::pair<uint32_t, double>> Query::parseQuery(const std::string &query,
+                                                           const Dictionary &wordTree,
+                                                           HashMap<std::string, std::vector<uint32_t>> &people,
+                                                           HashMap<std::string, std::vector<uint32_t>> &orgs,
+                                                           const StopWordSet &stopWords,
+                                                           const Scorer &scorer,
+                                                           size_t k)
+{
+    return parseQuery(analyzeQuery(query, stopWords), wordTree, people, orgs, scorer, k);
+}
+
+template <typename Dictionary>
+std::vector<std::pair<uint32_t, double>> Query::parseQuery(const Expression &expression,
+                                                           const Dictionary &wordTree,
+                                                           HashMap<std::string, std::vector<uint32_t>> &people,
+                                                           HashMap<std::string, std::vector<uint32_t>> &orgs,
+                                                           const Scorer &scorer,
+                                                           size_t k)
+{
+    expansions.clear();
+    decoded.clear();
+    scoredCount = 0;
+    std::vector<Operand> scored;
+    Step plan = compileQuery(expression, wordTree, people, orgs, false, scored);
+    if (pruning && k > 0 && isDisjunction(plan, scored))
+        return rankTopK(scored, scorer, k);
+    return rankResults(executeStep(plan), scored, scorer, k);
+}
 
-        // If finalMap is empty, initialize it with the current organization's documents
-        if (finalMap.empty())
+void Query::setPruning(bool skipUnrankable)
+{
+    pruning = skipUnrankable;
+}
+
+void Query::setWordFile(std::string_view bytes)
+{
+    wordFile = bytes;
+}
+
+size_t Query::documentsScored() const
+{
+    return scoredCount;
+}
+
+template <typename Dictionary>
+Query::Step Query::compileQuery(const Expression &expression,
+                                const Dictionary &wordTree,
+                                HashMap<std::string, std::vector<uint32_t>> &people,
+                                HashMap<std::string, std::vector<uint32_t>> &orgs,
+                                bool negated,
+                                std::vector<Operand> &scored)
+{
+    auto shorter = [](const Step &a, const Step &b) { return a.estimate < b.estimate; };
+    Step step;
+    step.kind = expression.kind;
+    switch (expression.kind)
+    {
+    case Expression::WORD:
+        step.postings = lookupWord(expression.word, wordTree, people, orgs);
+        if (step.postings.docs != nullptr)
         {
-            for (const auto &uuid : docs)
-            {
-                finalMap[uuid] = 1; // Initialize the relevancy score to 1
-            }
+            step.estimate = step.postings.docs->size();
+            if (!negated)
+                scored.push_back(step.postings);
         }
-        else
+        break;
+    case Expression::NOT:
+        step.operands.push_back(compileQuery(expression.operands.front(), wordTree, people, orgs, !negated, scored));
+        step.estimate = step.operands.front().estimate;
+        break;
+    case Expression::AND:
+    {
+        std::vector<Step> excluded;
+        for (const Expression &operand : expression.operands)
+        {
+            Step compiled = compileQuery(operand, wordTree, people, orgs, negated, scored);
+            if (compiled.kind != Expression::NOT)
+                step.operands.push_back(std::move(compiled));
+            else if (compiled.estimate > 0) // Excluding nothing changes nothing
+                excluded.push_back(std::move(compiled));
+        }
+
+        // Starting from the shortest list keeps every intermediate result as small as possible, and an
+        // operand without documents empties the whole AND, so nothing of it needs to run
+        std::sort(step.operands.begin(), step.operands.end(), shorter);
+        step.estimate = step.operands.empty() ? 0 : step.operands.front().estimate;
+        if (step.estimate == 0)
+        {
+            step.operands.clear();
+            break;
+        }
+        // The largest exclusions go first, since they remove the most candidates
+        std::sort(excluded.begin(), excluded.end(), [&shorter](const Step &a, const Step &b) { return shorter(b, a); });
+        for (Step &exclusion : excluded)
+            step.operands.push_back(std::move(exclusion));
+        break;
+    }
+    case Expression::OR:
+        // There is no list of every document to take a NOT away from, so a NOT only counts inside an AND
+        for (const Expression &operand : expression.operands)
         {
-            // If finalMap is not empty, retain only those documents that also appear for the current organization
-            for (auto iter = finalMap.begin(); iter != finalMap.end();)
+            Step compiled = compileQuery(operand, wordTree, people, orgs, negated, scored);
+            if (compiled.kind != Expression::NOT && compiled.estimate > 0)
             {
-                if (docs.find(iter->first) == docs.end())
-                {
-                    // If the document is not present for the current organization, remove it from finalMap
-                    iter = finalMap.erase(iter);
-                }
-                else
-                {
-                    // If the document is present, increment the relevancy score
-                    iter->second += 1;
-                    ++iter;
-                }
+                step.estimate += compiled.estimate;
+                step.operands.push_back(std::move(compiled));
             }
         }
+        std::sort(step.operands.begin(), step.operands.end(), shorter);
+        break;
+    case Expression::PHRASE:
+    case Expression::NEAR:
+        // The operands stay in query order, which is the order their positions have to follow
+        step.distance = expression.distance;
+        for (const Expression &operand : expression.operands)
+            step.operands.push_back(compileQuery(operand, wordTree, people, orgs, negated, scored));
+        step.estimate = std::min_element(step.operands.begin(), step.operands.end(), shorter)->estimate;
+        if (step.estimate == 0)
+        {
+            step.operands.clear();
+            break;
+        }
+        // A term loaded from a words file has its positions read from it now, for this query only
+        for (Step &operand : step.operands)
+        {
+            const PostingList *postings = operand.postings.postings;
+            if (postings == nullptr || postings->hasPositions() || postings->savedPositions() == 0 || wordFile.empty())
+                continue;
+            PostingList positional = *postings;
+            Index::readSavedPositions(wordFile, positional);
+            decoded.push_back(std::move(positional));
+            operand.postings = {&decoded.back().docs(), &decoded.back().frequencies(), &decoded.back()};
+        }
+        break;
+    }
+    return step;
+}
+
+template <typename Dictionary>
+Query::Operand Query::lookupWord(const Word &word,
+                                 const Dictionary &wordTree,
+                                 HashMap<std::string, std::vector<uint32_t>> &people,
+                                 HashMap<std::string, std::vector<uint32_t>> &orgs)
+{
+    switch (word.kind)
+    {
+    case Word::TERM:
+        if (const PostingList *postings = wordTree.find(word.text))
+            return {&postings->docs(), &postings->frequencies(), postings};
+        break;
+    case Word::PREFIX:
+        return expandPrefix(word.text, wordTree);
+    case Word::PERSON:
+        if (people.contains(word.text))
+            return {&people.getValues(word.text), nullptr};
+        break;
+    case Word::ORGANIZATION:
+        if (orgs.contains(word.text))
+            return {&orgs.getValues(word.text), nullptr};
+        break;
+    }
+    return {nullptr, nullptr};
+}
+
+template <typename Dictionary>
+Query::Operand Query::expandPrefix(const std::string &prefix, const Dictionary &wordTree)
+{
+    // The terms starting with the prefix are next to each other in the tree, so one range scan
+    // collects them. A document matches when it contains any of them, so the positions are not merged.
+    PostingList matches;
+    for (const auto &entry : wordTree.prefix_range(prefix))
+    {
+        matches.merge(entry.second, false);
     }
+    expansions.push_back(std::move(matches));
+    return {&expansions.back().docs(), &expansions.back().frequencies(), &expansions.back()};
 }
 
-void Query::parseAndProcessPeople(const std::string &person,
-                                  AvlTree<std::string, std::set<std::string>> &people,
-                                  std::map<std::string, int> &finalMap)
+std::vector<uint32_t> Query::executeStep(const Step &step)
 {
-    // Check if the person exists in the people tree
-    if (people.contains(person))
+    // The documents of an operand, without copying them when it is a word
+    auto documentsOf = [this](const Step &operand, std::vector<uint32_t> &storage) -> const std::vector<uint32_t> &
     {
-        // Retrieve the set of documents associated with the person
-        std::set<std::string> docs = people.getValues(person);
+        if (operand.kind == Expression::WORD && operand.postings.docs != nullptr)
+            return *operand.postings.docs;
+        storage = executeStep(operand);
+        return storage;
+    };
 
-        // If finalMap is empty, initialize it with the current person's documents
-        if (finalMap.empty())
+    std::vector<uint32_t> result, storage, next;
+    switch (step.kind)
+    {
+    case Expression::WORD:
+        if (step.postings.docs != nullptr)
+            result = *step.postings.docs;
+        break;
+    case Expression::NOT:
+        break; // Only runs as an operand of AND, which subtracts it
+    case Expression::AND:
+        if (step.operands.empty())
+            break;
+        result = documentsOf(step.operands.front(), storage);
+        for (size_t i = 1; i < step.operands.size() && !result.empty(); ++i)
         {
-            for (const auto &uuid : docs)
+            const Step &operand = step.operands[i];
+            if (operand.kind == Expression::NOT)
             {
-                finalMap[uuid] = 1; // Initialize the relevancy score to 1
+                const std::vector<uint32_t> &excluded = documentsOf(operand.operands.front(), storage);
+                result.resize(Intersection::subtract(result.data(), result.size(), excluded.data(), excluded.size()));
+                continue;
             }
+            const std::vector<uint32_t> &docs = documentsOf(operand, storage);
+            next.resize(result.size());
+            next.resize(Intersection::intersect(result.data(), result.size(), docs.data(), docs.size(), next.data()));
+            result.swap(next);
         }
-        else
+        break;
+    case Expression::OR:
+        for (const Step &operand : step.operands)
         {
-            // If finalMap is not empty, retain only those documents that also appear for the current person
-            for (auto iter = finalMap.begin(); iter != finalMap.end();)
+            const std::vector<uint32_t> &docs = documentsOf(operand, storage);
+            next.resize(result.size() + docs.size());
+            next.resize(std::set_union(result.begin(), result.end(), docs.begin(), docs.end(), next.begin()) -
+                        next.begin());
+            result.swap(next);
+        }
+        break;
+    case Expression::PHRASE:
+    case Expression::NEAR:
+    {
+        if (step.operands.empty())
+            break;
+
+        // The documents with every term first, intersected shortest list first like an AND
+        std::vector<const Step *> bySize;
+        for (const Step &operand : step.operands)
+            bySize.push_back(&operand);
+        std::sort(bySize.begin(), bySize.end(), [](const Step *a, const Step *b) { return a->estimate < b->estimate; });
+        result = *bySize.front()->postings.docs;
+        for (size_t i = 1; i < bySize.size() && !result.empty(); ++i)
+        {
+            const std::vector<uint32_t> &docs = *bySize[i]->postings.docs;
+            next.resize(result.size());
+            next.resize(Intersection::intersect(result.data(), result.size(), docs.data(), docs.size(), next.data()));
+            result.swap(next);
+        }
+
+        // Then only those where the positions line up. Without positions the terms only have to co-occur.
+        bool positional = std::all_of(step.operands.begin(), step.operands.end(), [](const Step &operand)
+                                      { return operand.postings.postings != nullptr && operand.postings.postings->hasPositions(); });
+        if (!positional)
+            break;
+        std::vector<size_t> at(step.operands.size(), 0);
+        size_t kept = 0;
+        for (uint32_t id : result)
+        {
+            for (size_t i = 0; i < step.operands.size(); ++i)
             {
-                if (docs.find(iter->first) == docs.end())
-                {
-                    // If the document is not present for the current person, remove it from finalMap
-                    iter = finalMap.erase(iter);
-                }
-                else
-                {
-                    // If the document is present, increment the relevancy score
-                    iter->second += 1;
-                    ++iter;
-                }
+                const std::vector<uint32_t> &docs = *step.operands[i].postings.docs;
+                at[i] = Intersection::gallop(docs.data(), docs.size(), at[i], id);
             }
+            if (matchesPositions(step, at))
+                result[kept++] = id;
         }
+        result.resize(kept);
+        break;
+    }
     }
+    return result;
 }
 
-void Query::excludeTerms(const std::set<std::string> &terms,
-                         std::map<std::string, int> &finalMap)
+bool Query::matchesPositions(const Step &step, const std::vector<size_t> &at) const
 {
-    // Loop through each term in the set of terms to be excluded
-    for (const auto &term : terms)
+    auto positionsOf = [&step, &at](size_t i) { return step.operands[i].postings.postings->positionsAt(at[i]); };
+    if (step.kind == Expression::NEAR)
     {
-        // Remove any entries from finalMap that match the excluded terms
-        for (auto it = finalMap.begin(); it != finalMap.end();)
+        // Walk both position lists in order, the closest pair is always next to each other in the walk
+        auto [a, aEnd] = positionsOf(0);
+        auto [b, bEnd] = positionsOf(1);
+        while (a != aEnd && b != bEnd)
         {
-            if (it->first == term)
-            {
-                it = finalMap.erase(it); // Erase and advance the iterator
-            }
+            if ((*a < *b ? *b - *a : *a - *b) <= step.distance)
+                return true;
+            if (*a < *b)
+                ++a;
             else
-            {
-                ++it; // Advance the iterator
-            }
+                ++b;
+        }
+        return false;
+    }
+
+    // A phrase starts at a position of its first term where term i follows at i positions further
+    auto [first, firstEnd] = positionsOf(0);
+    for (; first != firstEnd; ++first)
+    {
+        size_t i = 1;
+        while (i < step.operands.size())
+        {
+            auto [begin, end] = positionsOf(i);
+            if (!std::binary_search(begin, end, *first + static_cast<uint32_t>(i)))
+                break;
+            ++i;
+        }
+        if (i == step.operands.size())
+            return true;
+    }
+    return false;
+}
+
+std::vector<std::pair<uint32_t, double>> Query::rankResults(const std::vector<uint32_t> &finalDocs,
+                                                            const std::vector<Operand> &operands,
+                                                            const Scorer &scorer,
+                                                            size_t k)
+{
+    // Better results compare first: higher score, then lower ID so that ties rank the same every time
+    auto better = [](const std::pair<uint32_t, double> &a, const std::pair<uint32_t, double> &b)
+    {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    if (k == 0 || k > finalDocs.size())
+        k = finalDocs.size();
+
+    // The documents are ascending, so each operand is searched from where the previous one was found
+    std::vector<size_t> positions(operands.size(), 0);
+    std::vector<std::pair<uint32_t, double>> rankedResults; // heap whose top is the worst kept result
+    rankedResults.reserve(k);
+    scoredCount += finalDocs.size();
+    for (uint32_t id : finalDocs)
+    {
+        double score = 0;
+        for (size_t i = 0; i < operands.size(); ++i)
+        {
+            const std::vector<uint32_t> &docs = *operands[i].docs;
+            positions[i] = Intersection::gallop(docs.data(), docs.size(), positions[i], id);
+            if (positions[i] == docs.size() || docs[positions[i]] != id)
+                continue; // A document matching an OR need not contain every word
+            int frequency = operands[i].counts != nullptr ? (*operands[i].counts)[positions[i]] : 1;
+            score += scorer.score(frequency, docs.size(), id);
+        }
+
+        if (rankedResults.size() < k)
+        {
+            rankedResults.emplace_back(id, score);
+            std::push_heap(rankedResults.begin(), rankedResults.end(), better);
+        }
+        else if (k > 0 && better({id, score}, rankedResults.front()))
+        {
+            std::pop_heap(rankedResults.begin(), rankedResults.end(), better);
+            rankedResults.back() = {id, score};
+            std::push_heap(rankedResults.begin(), rankedResults.end(), better);
         }
     }
+
+    // Sort the kept results in descending order of relevancy
+    std::sort_heap(rankedResults.begin(), rankedResults.end(), better);
+    return rankedResults;
+}
+
+bool Query::isDisjunction(const Step &plan, const std::vector<Operand> &scored) const
+{
+    size_t words = 1;
+    if (plan.kind == Expression::OR)
+    {
+        words = plan.operands.size();
+        for (const Step &operand : plan.operands)
+            if (operand.kind != Expression::WORD)
+                return false;
+    }
+    else if (plan.kind != Expression::WORD)
+    {
+        return false;
+    }
+
+    // A word the plan left out, like one of an AND that matches nothing, still adds to the score of
+    // the documents it occurs in, so the plan has to hold every scored word that has documents
+    return words == static_cast<size_t>(std::count_if(scored.begin(), scored.end(), [](const Operand &operand)
+                                                      { return !operand.docs->empty(); }));
 }
 
-std::vector<std::pair<std::string, int>> Query::rankResults(std::map<std::string, int> &finalMap)
+std::vector<std::pair<uint32_t, double>> Query::rankTopK(const std::vector<Operand> &operands,
+                                                         const Scorer &scorer,
+                                                         size_t k)
 {
-    // Convert the finalMap into a vector of pairs for sorting
-    std::vector<std::pair<std::string, int>> rankedResults(finalMap.begin(), finalMap.end());
+    // The same order as rankResults(), so both keep the same documents
+    auto better = [](const std::pair<uint32_t, double> &a, const std::pair<uint32_t, double> &b)
+    {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+
+    // The bounds come from the block maxima of the postings. They are widened a little so that adding
+    // them up in another order than a score cannot round them below it.
+    std::vector<Cursor> cursors;
+    cursors.reserve(operands.size());
+    for (const Operand &operand : operands)
+    {
+        Cursor cursor(operand.docs->data(), operand.counts != nullptr ? operand.counts->data() : nullptr,
+                      operand.docs->size());
+        for (size_t b = 0; b * PostingList::BLOCK_SIZE < cursor.size; ++b)
+        {
+            int maximum = operand.postings != nullptr ? operand.postings->blockMaxima()[b] : 1;
+            double bound = scorer.maxScore(maximum, cursor.size);
+            cursor.blockBounds.push_back(bound + std::abs(bound) * 1e-9);
+            cursor.bound = std::max(cursor.bound, cursor.blockBounds.back());
+        }
+        cursors.push_back(std::move(cursor));
+    }
+
+    std::vector<Cursor *> order;
+    for (Cursor &cursor : cursors)
+        order.push_back(&cursor);
+    std::vector<std::pair<uint32_t, double>> rankedResults; // heap whose top is the worst kept result
+    rankedResults.reserve(k);
+    while (true)
+    {
+        std::sort(order.begin(), order.end(), [](const Cursor *a, const Cursor *b) { return a->doc() < b->doc(); });
 
-    // Sort the results based on the frequency count or relevancy score in descending order
-    std::sort(rankedResults.begin(), rankedResults.end(),
-              [](const std::pair<std::string, int> &a, const std::pair<std::string, int> &b)
-              {
-                  return a.second > b.second;
-              });
+        // A document has to score above the worst kept result to replace it, since the documents come in
+        // ascending order and ties go to the lower ID
+        double threshold = rankedResults.size() < k ? -std::numeric_limits<double>::infinity()
+                                                    : rankedResults.front().second;
 
+        // The candidate is the document of the first cursor that brings the bounds of the cursors up to
+        // it above the threshold. The documents before it only occur in the cursors before it.
+        size_t pivot = 0;
+        for (double upper = 0; pivot < order.size() && order[pivot]->doc() != END; ++pivot)
+        {
+            upper += order[pivot]->bound;
+            if (upper > threshold)
+                break;
+        }
+        if (pivot == order.size() || order[pivot]->doc() == END)
+            break;
+        uint32_t candidate = order[pivot]->doc();
+        size_t last = pivot;
+        while (last + 1 < order.size() && order[last + 1]->doc() == candidate)
+            last++;
+
+        // Up to next, every document from the candidate on lies in the same block of the cursors up to
+        // last, and occurs in no other cursor, so their block bounds bound its score
+        uint32_t next = last + 1 < order.size() ? order[last + 1]->doc() : END;
+        double blockUpper = 0;
+        for (size_t i = 0; i <= last; ++i)
+        {
+            Cursor &cursor = *order[i];
+            cursor.block = std::max(cursor.block, cursor.at / PostingList::BLOCK_SIZE);
+            while (cursor.block < cursor.blockBounds.size() && cursor.lastOf(cursor.block) < candidate)
+                cursor.block++;
+            if (cursor.block == cursor.blockBounds.size())
+                continue; // No document from the candidate on
+            blockUpper += cursor.blockBounds[cursor.block];
+            next = std::min(next, cursor.lastOf(cursor.block) + 1);
+        }
+        if (!(blockUpper > threshold))
+        {
+            for (size_t i = 0; i <= last; ++i)
+                order[i]->seek(next);
+            continue;
+        }
+
+        // Before the candidate is scored, the cursors behind it have to reach it
+        if (order[0]->doc() != candidate)
+        {
+            for (size_t i = 0; i < pivot; ++i)
+                order[i]->seek(candidate);
+            continue;
+        }
+
+        // The cursors at the candidate are the ones up to last. Adding them up in operand order gives the
+        // score rankResults() does.
+        double score = 0;
+        for (Cursor &cursor : cursors)
+        {
+            if (cursor.doc() != candidate)
+                continue;
+            int frequency = cursor.counts != nullptr ? cursor.counts[cursor.at] : 1;
+            score += scorer.score(frequency, cursor.size, candidate);
+            cursor.at++;
+        }
+        scoredCount++;
+
+        if (rankedResults.size() < k)
+        {
+            rankedResults.emplace_back(candidate, score);
+            std::push_heap(rankedResults.begin(), rankedResults.end(), better);
+        }
+        else if (better({candidate, score}, rankedResults.front()))
+        {
+            std::pop_heap(rankedResults.begin(), rankedResults.end(), better);
+            rankedResults.back() = {candidate, score};
+            std::push_heap(rankedResults.begin(), rankedResults.end(), better);
+        }
+    }
+
+    std::sort_heap(rankedResults.begin(), rankedResults.end(), better);
     return rankedResults;
 }
+
+// The word dictionaries parseQuery() is used with
+template std::vector<std::pair<uint32_t, double>> Query::parseQuery(
+    const std::string &, const AvlTree<std::string, PostingList> &, HashMap<std::string, std::vector<uint32_t>> &,
+    HashMap<std::string, std::vector<uint32_t>> &, const StopWordSet &, const Scorer &, size_t);
+template std::vector<std::pair<uint32_t, double>> Query::parseQuery(
+    const std::string &, const FrozenDictionary<PostingList> &, HashMap<std::string, std::vector<uint32_t>> &,
+    HashMap<std::string, std::vector<uint32_t>> &, const StopWordSet &, const Scorer &, size_t);
+template std::vector<std::pair<uint32_t, double>> Query::parseQuery(
+    const Expression &, const AvlTree<std::string, PostingList> &, HashMap<std::string, std::vector<uint32_t>> &,
+    HashMap<std::string, std::vector<uint32_t>> &, const Scorer &, size_t);
+template std::vector<std::pair<uint32_t, double>> Query::parseQuery(
+    const Expression &, const FrozenDictionary<PostingList> &, HashMap<std::string, std::vector<uint32_t>> &,
+    HashMap<std::string, std::vector<uint32_t>> &, const Scorer &, size_t);
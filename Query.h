@@ -1,42 +1,184 @@
 #ifndef QUERY_H
 #define QUERY_H
 
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
-#include "AvlTree.h"
+#include "AVLTree.h"
+#include "Analyzer.h"
+#include "FrozenDictionary.h"
+#include "HashMap.h"
+#include "PostingList.h"
+#include "Scorer.h"
+#include "StopWords.h"
 
+// Query evaluates boolean queries over the word, person and organization indexes. A query is a list of
+// words that all have to match, which can be combined further with
+//   a OR b       either of two expressions, binding looser than AND
+//   a AND b      both of them, the same as "a b"
+//   NOT a, -a    the documents of the expression before it without those of a
+//   ( ... )      grouping
+//   "a b c"      a phrase, its terms right after each other
+//   a NEAR/k b   two terms at most k terms apart, in either order
+// Words are terms, term prefixes ending in '*', org:name and person:name. The operators are only
+// recognized in capitals, so a lowercase "or" is an ordinary (stop) word. Unbalanced parentheses
+// and operators without an operand are forgiven rather than rejected. Phrases and NEAR need an index
+// built with positions; on one without, they match like an AND of their terms.
 class Query {
 public:
     Query() = default;
 
-    // Parses the query entered by the user and updates the finalDocs vector with relevant documents
-    std::vector<std::pair<std::string, int>> parseQuery(const std::string& query,
-                    AvlTree<std::string, std::map<std::string, int>>& wordTree,
-                    AvlTree<std::string, std::set<std::string>>& people,
-                    AvlTree<std::string, std::set<std::string>>& orgs,
-                    AvlTree<std::string, std::string>& stopWords);
+    // One word of a query, with the text it is looked up by
+    struct Word {
+        enum Kind { TERM, PREFIX, PERSON, ORGANIZATION };
+        Kind kind;
+        std::string text; // the term for TERM, the lowercased rest of the word otherwise
+    };
+
+    // Syntax tree of a query. An AND or OR without operands matches no documents; analyzeQuery() returns
+    // one for a query without any word that is indexed.
+    struct Expression {
+        enum Kind { WORD, AND, OR, NOT, PHRASE, NEAR };
+        Kind kind = AND;
+        Word word{Word::TERM, ""};           // the word of a WORD
+        std::vector<Expression> operands;   // the operands of AND and OR, the single one of NOT, the
+                                            // term WORDs of PHRASE (in order) and NEAR
+        uint32_t distance = 0;              // the k of NEAR/k
+    };
+
+    // Parses the query entered by the user into its syntax tree. Terms go through the same Analyzer
+    // steps as the documents did, so they are stemmed, and words without a term are left out.
+    Expression analyzeQuery(const std::string& query, const StopWordSet& stopWords);
+
+    // Calls visit(const Word &, bool positional) for every word of an expression, the ones under NOT
+    // included. positional tells whether the word is part of a phrase or NEAR, which read its positions.
+    template <typename Visitor>
+    static void forEachWord(const Expression& expression, Visitor&& visit, bool positional = false) {
+        if (expression.kind == Expression::WORD)
+            visit(expression.word, positional);
+        positional = positional || expression.kind == Expression::PHRASE || expression.kind == Expression::NEAR;
+        for (const Expression& operand : expression.operands)
+            forEachWord(operand, visit, positional);
+    }
+
+    // Parses the query entered by the user and returns the k most relevant documents with their
+    // scores, best first. k = 0 returns every matching document. The word dictionary is an
+    // AvlTree<std::string, PostingList> or, for an index that no longer changes, a
+    // FrozenDictionary<PostingList>; Query.cpp instantiates both.
+    template <typename Dictionary>
+    std::vector<std::pair<uint32_t, double>> parseQuery(const std::string& query,
+                    const Dictionary& wordTree,
+                    HashMap<std::string, std::vector<uint32_t>>& people,
+                    HashMap<std::string, std::vector<uint32_t>>& orgs,
+                    const StopWordSet& stopWords,
+                    const Scorer& scorer,
+                    size_t k = 0);
+
+    // Same as above for a query analyzeQuery() has already parsed
+    template <typename Dictionary>
+    std::vector<std::pair<uint32_t, double>> parseQuery(const Expression& expression,
+                    const Dictionary& wordTree,
+                    HashMap<std::string, std::vector<uint32_t>>& people,
+                    HashMap<std::string, std::vector<uint32_t>>& orgs,
+                    const Scorer& scorer,
+                    size_t k = 0);
+
+    // Whether a top-k query that is an OR of words skips the documents that cannot rank (on by
+    // default). The results are the same either way, turning it off is for comparing the two.
+    void setPruning(bool skipUnrankable);
+
+    // The words file the dictionary's lists were loaded from (see Index::loadWordData), which phrase and
+    // NEAR queries read the positions of their terms from. It has to outlive the queries.
+    void setWordFile(std::string_view bytes);
+
+    // Number of documents the last parseQuery() computed a score for
+    size_t documentsScored() const;
 
 private:
-    // Helper methods for parsing different aspects of the query
-    void parseAndProcessTerms(const std::string& query,
-                              AvlTree<std::string, std::map<std::string, int>>& wordTree,
-                              std::map<std::string, int>& finalDocs);
+    // A list of documents a word appears in. Terms carry their frequencies, people and organizations
+    // occur once in each of their documents.
+    struct Operand {
+        const std::vector<uint32_t>* docs;
+        const std::vector<int>* counts;       // nullptr for people and organizations
+        const PostingList* postings = nullptr; // the list of a term or prefix, which may have positions
+    };
+
+    // One node of the query plan compileQuery() makes from an Expression
+    struct Step {
+        Expression::Kind kind;
+        Operand postings{nullptr, nullptr}; // the documents of a WORD, docs is nullptr when there are none
+        size_t estimate = 0;                // most documents the step can match
+        std::vector<Step> operands;         // AND runs them in this order, the ones under NOT last
+        uint32_t distance = 0;              // the k of NEAR/k
+    };
+
+    // Recursive descent parser over the tokens of a query, one function per precedence level. pos is
+    // the next token to read.
+    Expression parseOr(const std::vector<std::string>& tokens, size_t& pos, const StopWordSet& stopWords);
+    Expression parseAnd(const std::vector<std::string>& tokens, size_t& pos, const StopWordSet& stopWords);
+    Expression parseNear(const std::vector<std::string>& tokens, size_t& pos, const StopWordSet& stopWords);
+    Expression parseUnary(const std::vector<std::string>& tokens, size_t& pos, const StopWordSet& stopWords);
+    Expression parseWord(std::string word, const StopWordSet& stopWords);
+    Expression parsePhrase(std::string_view text, const StopWordSet& stopWords);
+
+    // Looks up the postings of every word and orders the operands of every AND so that the most
+    // selective run first. An AND with an operand that matches nothing becomes empty without its other
+    // operands being looked at again. Positive words are added to scored, which ranks the results. The
+    // terms of a phrase or NEAR that were loaded without their positions have them read from the words file.
+    template <typename Dictionary>
+    Step compileQuery(const Expression& expression,
+                      const Dictionary& wordTree,
+                      HashMap<std::string, std::vector<uint32_t>>& people,
+                      HashMap<std::string, std::vector<uint32_t>>& orgs,
+                      bool negated,
+                      std::vector<Operand>& scored);
+
+    template <typename Dictionary>
+    Operand lookupWord(const Word& word,
+                       const Dictionary& wordTree,
+                       HashMap<std::string, std::vector<uint32_t>>& people,
+                       HashMap<std::string, std::vector<uint32_t>>& orgs);
+
+    // A term ending in '*' stands for every term that starts with the rest of it. Its postings are the
+    // union of theirs, kept in expansions.
+    template <typename Dictionary>
+    Operand expandPrefix(const std::string& prefix, const Dictionary& wordTree);
+
+    // Runs a step of the plan, returns the documents it matches in ascending order
+    std::vector<uint32_t> executeStep(const Step& step);
+
+    // Whether the terms of a PHRASE or NEAR step occur in a document as it requires, at[i] being the
+    // posting of the document in the list of term i
+    bool matchesPositions(const Step& step, const std::vector<size_t>& at) const;
 
-    void parseAndProcessOrgs(const std::string& query,
-                             AvlTree<std::string, std::set<std::string>>& orgs,
-                             std::map<std::string, int>& finalDocs);
+    // Method for ranking the results based on relevancy, keeps the best k in a bounded heap
+    std::vector<std::pair<uint32_t, double>> rankResults(const std::vector<uint32_t>& finalDocs,
+                                                         const std::vector<Operand>& operands,
+                                                         const Scorer& scorer,
+                                                         size_t k);
 
-    void parseAndProcessPeople(const std::string& query,
-                               AvlTree<std::string, std::set<std::string>>& people,
-                               std::map<std::string, int>& finalDocs);
+    // Whether rankTopK() can rank a plan: a single word or an OR of words that are all the scored ones
+    bool isDisjunction(const Step& plan, const std::vector<Operand>& scored) const;
 
-    void excludeTerms(const std::set<std::string>& terms,
-                      std::map<std::string, int>& finalDocs);
+    // Ranks the documents containing any of the operands like rankResults() does, without scoring the
+    // ones that cannot make the best k. This is Block-Max WAND: the operands are kept in order of
+    // their next document, and only a document whose operands can add up to more than the k-th best
+    // score so far is scored, first by the most they can give anywhere (WAND), then by the most they
+    // can give in the blocks of their postings holding it (block-max). k has to be above 0.
+    std::vector<std::pair<uint32_t, double>> rankTopK(const std::vector<Operand>& operands,
+                                                      const Scorer& scorer,
+                                                      size_t k);
 
-    // Method for ranking the results based on relevancy
-    std::vector<std::pair<std::string, int>> rankResults(std::map<std::string, int>& finalDocs);
+    Analyzer analyzer; // turns query words into terms, the same way DocumentParser turns text into them
+    std::deque<PostingList> expansions; // postings of the prefix terms of the last query
+    std::deque<PostingList> decoded;    // phrase and NEAR terms of the last query whose saved positions
+                                        // it decoded
+    std::string_view wordFile;          // setWordFile()
+    bool pruning = true;                // whether rankTopK() ranks the queries it can
+    size_t scoredCount = 0;             // documentsScored()
 };
 
 #endif // QUERY_H
@@ -0,0 +1,65 @@
+#include "Scorer.h"
+
+#include <cmath>
+
+double Bm25Scorer::score(int frequency, size_t documentFrequency, uint32_t document) const
+{
+    double n = statistics.documentCount;
+    double idf = std::log(1 + (n - documentFrequency + 0.5) / (documentFrequency + 0.5));
+
+    // Without length information every document counts as average
+    double relativeLength = 1;
+    if (statistics.averageLength > 0 && statistics.lengthOf)
+        relativeLength = statistics.lengthOf(document) / statistics.averageLength;
+
+    return idf * frequency * (k1 + 1) / (frequency + k1 * (1 - b + b * relativeLength));
+}
+
+// The score grows with the frequency and shrinks with the length, so no document scores more than an
+// empty one would
+double Bm25Scorer::maxScore(int frequency, size_t documentFrequency) const
+{
+    double n = statistics.documentCount;
+    double idf = std::log(1 + (n - documentFrequency + 0.5) / (documentFrequency + 0.5));
+
+    // Without length information every document scores as an average one
+    double relativeLength = statistics.averageLength > 0 && statistics.lengthOf ? 0 : 1;
+
+    return idf * frequency * (k1 + 1) / (frequency + k1 * (1 - b + b * relativeLength));
+}
+
+double TfIdfScorer::score(int frequency, size_t documentFrequency, uint32_t) const
+{
+    if (frequency <= 0 || documentFrequency == 0)
+        return 0;
+    return (1 + std::log(frequency)) * std::log(1 + static_cast<double>(statistics.documentCount) / documentFrequency);
+}
+
+double TfIdfScorer::maxScore(int frequency, size_t documentFrequency) const
+{
+    return score(frequency, documentFrequency, 0);
+}
+
+double FrequencyScorer::score(int frequency, size_t, uint32_t) const
+{
+    return frequency;
+}
+
+double FrequencyScorer::maxScore(int frequency, size_t) const
+{
+    return frequency;
+}
+
+std::unique_ptr<Scorer> makeScorer(Scoring scoring, CollectionStatistics statistics)
+{
+    switch (scoring)
+    {
+    case Scoring::TF_IDF:
+        return std::make_unique<TfIdfScorer>(std::move(statistics));
+    case Scoring::FREQUENCY:
+        return std::make_unique<FrequencyScorer>(std::move(statistics));
+    case Scoring::BM25:
+    default:
+        return std::make_unique<Bm25Scorer>(std::move(statistics));
+    }
+}
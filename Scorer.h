@@ -0,0 +1,86 @@
+#ifndef SCORER_H
+#define SCORER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <memory>
+
+// What a scoring function may know about the indexed collection
+struct CollectionStatistics
+{
+    uint32_t documentCount = 0;                 // number of documents in the index
+    double averageLength = 0;                   // average length of a document in tokens
+    std::function<uint32_t(uint32_t)> lengthOf; // length in tokens of a document ID
+};
+
+// A Scorer gives the relevancy of a document for one query term. The score of a document is the sum
+// over all terms, people and organizations of the query, a person or organization counting as a
+// term that occurs once.
+class Scorer
+{
+public:
+    explicit Scorer(CollectionStatistics statistics) : statistics{std::move(statistics)} {}
+    virtual ~Scorer() = default;
+
+    // frequency is how often the term occurs in the document, documentFrequency in how many documents
+    // of the collection it occurs
+    virtual double score(int frequency, size_t documentFrequency, uint32_t document) const = 0;
+
+    // The most score() can give any document for a term occurring at most frequency times in it, so
+    // that top-k queries can skip documents that cannot rank. A scorer that cannot tell returns
+    // infinity, which skips nothing.
+    virtual double maxScore(int, size_t) const { return std::numeric_limits<double>::infinity(); }
+
+protected:
+    CollectionStatistics statistics;
+};
+
+// Okapi BM25, the default
+class Bm25Scorer : public Scorer
+{
+public:
+    explicit Bm25Scorer(CollectionStatistics statistics, double k1 = 1.2, double b = 0.75)
+        : Scorer(std::move(statistics)), k1{k1}, b{b} {}
+
+    double score(int frequency, size_t documentFrequency, uint32_t document) const override;
+    double maxScore(int frequency, size_t documentFrequency) const override;
+
+private:
+    double k1; // how quickly repeated occurrences stop adding to the score
+    double b;  // how strongly the score is normalized by document length
+};
+
+// Log-scaled term frequency times inverse document frequency
+class TfIdfScorer : public Scorer
+{
+public:
+    using Scorer::Scorer;
+
+    double score(int frequency, size_t documentFrequency, uint32_t document) const override;
+    double maxScore(int frequency, size_t documentFrequency) const override;
+};
+
+// Summed raw term frequencies, how results were ranked originally
+class FrequencyScorer : public Scorer
+{
+public:
+    using Scorer::Scorer;
+
+    double score(int frequency, size_t documentFrequency, uint32_t document) const override;
+    double maxScore(int frequency, size_t documentFrequency) const override;
+};
+
+enum class Scoring
+{
+    BM25,
+    TF_IDF,
+    FREQUENCY
+};
+
+// Creates the scorer for a scoring function
+std::unique_ptr<Scorer> makeScorer(Scoring scoring, CollectionStatistics statistics);
+
+#endif // SCORER_H
@@ -0,0 +1,31 @@
+#include "StemCache.h"
+#include "porter2_stemmer.h"
+
+// The table is not reserved up front, it grows with the words cached, so a cache that only stems a
+// few query words stays small
+StemCache::StemCache(size_t capacity) : capacity{capacity}
+{
+}
+
+void StemCache::stem(std::string &word)
+{
+    auto found = stems.find(word);
+    if (found != stems.end())
+    {
+        counts.hits++;
+        word = found->second;
+        return;
+    }
+
+    counts.misses++;
+    if (stems.size() >= capacity)
+        stems.clear();
+    std::string surface = word;
+    Porter2Stemmer::stem(word);
+    stems.emplace(std::move(surface), word);
+}
+
+const StemCache::Statistics &StemCache::statistics() const
+{
+    return counts;
+}
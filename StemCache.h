@@ -0,0 +1,48 @@
+#ifndef STEMCACHE_H
+#define STEMCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// StemCache remembers the Porter2 stem of every word it has stemmed, so the frequent words of a
+// corpus go through the suffix rules only once. It is not thread-safe; every DocumentParser owns one,
+// so parallel workers each have their own. Once capacity words are cached the cache starts over,
+// which keeps memory bounded while the frequent words quickly come back.
+class StemCache
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 16;
+
+    // Hit and miss counts of one or more caches
+    struct Statistics
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        uint64_t lookups() const { return hits + misses; }
+        double hitRate() const { return lookups() > 0 ? static_cast<double>(hits) / lookups() : 0; }
+
+        Statistics &operator+=(const Statistics &other)
+        {
+            hits += other.hits;
+            misses += other.misses;
+            return *this;
+        }
+    };
+
+    explicit StemCache(size_t capacity = DEFAULT_CAPACITY);
+
+    // Replaces word by its stem, like Porter2Stemmer::stem
+    void stem(std::string &word);
+
+    const Statistics &statistics() const;
+
+private:
+    std::unordered_map<std::string, std::string> stems; // stem of every cached word
+    size_t capacity;
+    Statistics counts;
+};
+
+#endif // STEMCACHE_H
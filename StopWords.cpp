@@ -0,0 +1,121 @@
+#include "StopWords.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+StopWordSet::StopWordSet()
+{
+    static const StopWordSet english(
+        std::vector<std::string>(ENGLISH_STOP_WORDS.begin(), ENGLISH_STOP_WORDS.end()));
+    *this = english;
+}
+
+StopWordSet::StopWordSet(const std::vector<std::string> &words)
+{
+    build(words);
+}
+
+bool StopWordSet::contains(std::string_view word) const
+{
+    if (word.empty() || slots.empty())
+        return false;
+    return slots[slotOf(hash(word))] == word;
+}
+
+size_t StopWordSet::size() const
+{
+    return count;
+}
+
+// build() places the largest buckets first, while the table is still empty, and tries displacements
+// for each bucket until all of its words fit. When a bucket cannot be placed the whole table is
+// rebuilt with the next seed.
+void StopWordSet::build(std::vector<std::string> words)
+{
+    words.erase(std::remove(words.begin(), words.end(), std::string()), words.end());
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    count = words.size();
+    if (words.empty())
+    {
+        slots.clear();
+        displacements.clear();
+        return;
+    }
+
+    const uint32_t MAX_DISPLACEMENT = 1 << 16;
+    // Both sizes are powers of two so that slotOf() can mask instead of divide
+    size_t tableSize = 1, bucketCount = 1;
+    while (tableSize < words.size() + words.size() / 4 + 1)
+        tableSize *= 2;
+    while (bucketCount < words.size() / 4 + 1)
+        bucketCount *= 2;
+
+    for (seed = 0; seed < 64; ++seed)
+    {
+        slots.assign(tableSize, std::string());
+        displacements.assign(bucketCount, 0);
+
+        std::vector<std::vector<size_t>> buckets(bucketCount);
+        std::vector<uint64_t> hashes(words.size());
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            hashes[i] = hash(words[i]);
+            buckets[hashes[i] & (bucketCount - 1)].push_back(i);
+        }
+        std::vector<size_t> order(bucketCount);
+        for (size_t b = 0; b < bucketCount; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b)
+                         { return buckets[a].size() > buckets[b].size(); });
+
+        bool placed = true;
+        std::vector<size_t> taken;
+        for (size_t b : order)
+        {
+            uint32_t d = 0;
+            for (; d < MAX_DISPLACEMENT; ++d)
+            {
+                displacements[b] = d;
+                taken.clear();
+                for (size_t i : buckets[b])
+                {
+                    size_t slot = slotOf(hashes[i]);
+                    if (!slots[slot].empty() || std::find(taken.begin(), taken.end(), slot) != taken.end())
+                        break;
+                    taken.push_back(slot);
+                }
+                if (taken.size() == buckets[b].size())
+                    break;
+            }
+            if (d == MAX_DISPLACEMENT)
+            {
+                placed = false;
+                break;
+            }
+            for (size_t k = 0; k < taken.size(); ++k)
+                slots[taken[k]] = words[buckets[b][k]];
+        }
+        if (placed)
+            return;
+    }
+    throw std::runtime_error("Could not build a perfect hash of the stop words");
+}
+
+// hash() is a seeded FNV-1a with a final mix. Stop words are a few bytes long, where it is cheaper
+// than MurmurHash3.
+uint64_t StopWordSet::hash(std::string_view word) const
+{
+    uint64_t h = 14695981039346656037ULL ^ seed;
+    for (unsigned char c : word)
+        h = (h ^ c) * 1099511628211ULL;
+    return h ^ (h >> 29);
+}
+
+// slotOf() derives the bucket and the slot from the two halves of the same hash
+size_t StopWordSet::slotOf(uint64_t hash) const
+{
+    uint32_t displacement = displacements[hash & (displacements.size() - 1)];
+    uint64_t low = hash & 0xffffffff, high = (hash >> 32) | 1;
+    return (low + displacement * high) & (slots.size() - 1);
+}
@@ -0,0 +1,58 @@
+#ifndef STOPWORDS_H
+#define STOPWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The default English stop list, written the way the Tokenizer emits tokens: lowercase and without
+// apostrophes, so "don't" is "dont".
+constexpr std::array<std::string_view, 158> ENGLISH_STOP_WORDS = {
+    "i", "me", "my", "myself", "we", "our", "ours", "ourselves", "you", "youre", "youve", "youll",
+    "youd", "your", "yours", "yourself", "yourselves", "he", "him", "his", "himself", "she", "shes",
+    "her", "hers", "herself", "it", "its", "itself", "they", "them", "their", "theirs", "themselves",
+    "what", "which", "who", "whom", "this", "that", "thatll", "these", "those", "am", "is", "are",
+    "was", "were", "be", "been", "being", "have", "has", "had", "having", "do", "does", "did", "doing",
+    "a", "an", "the", "and", "but", "if", "or", "because", "as", "until", "while", "of", "at", "by",
+    "for", "with", "about", "against", "between", "into", "through", "during", "before", "after",
+    "above", "below", "to", "from", "up", "down", "in", "out", "on", "off", "over", "under", "again",
+    "further", "then", "once", "here", "there", "when", "where", "why", "how", "all", "any", "both",
+    "each", "few", "more", "most", "other", "some", "such", "no", "nor", "not", "only", "own", "same",
+    "so", "than", "too", "very", "s", "t", "can", "will", "just", "don", "dont", "should",
+    "shouldve", "now", "d", "ll", "m", "o", "re", "ve", "y", "aint", "arent", "couldnt", "didnt",
+    "doesnt", "hadnt", "hasnt", "havent", "isnt", "mightnt", "mustnt", "shouldnt", "wasnt", "werent",
+    "wont", "wouldnt"};
+
+// StopWordSet answers whether a word is a stop word with one hash and one string compare. The words
+// are placed in a collision free table by hash and displace: a word's hash picks a bucket, and every
+// bucket has its own displacement chosen at build time so that all of its words land in empty slots.
+// The hash is perfect but not minimal: the table has a power of two slots, at least 1.25 per word,
+// so that a slot is found by masking and a displacement for every bucket is quick to find.
+class StopWordSet
+{
+public:
+    // The set of ENGLISH_STOP_WORDS, a copy of a table built once per program
+    StopWordSet();
+
+    // Builds the set of the given words, duplicates are ignored
+    explicit StopWordSet(const std::vector<std::string> &words);
+
+    bool contains(std::string_view word) const;
+
+    size_t size() const;
+
+private:
+    void build(std::vector<std::string> words);
+    uint64_t hash(std::string_view word) const;
+    size_t slotOf(uint64_t hash) const;
+
+    std::vector<std::string> slots;        // every word at its slot, "" for empty slots
+    std::vector<uint32_t> displacements;   // displacement of every bucket
+    uint64_t seed = 0;
+    size_t count = 0;
+};
+
+#endif // STOPWORDS_H
@@ -0,0 +1,64 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <array>
+#include <string>
+#include <string_view>
+
+// Splits text into tokens in a single pass. Tokens are separated by whitespace, punctuation inside a
+// token is dropped and letters are lowercased, like the istringstream, remove_if and transform passes
+// DocumentParser used to make. Every byte is classified with one table lookup.
+namespace Tokenizer
+{
+    // Table entries below FIRST_KEPT mark bytes that are not copied into a token
+    const unsigned char SEPARATOR = 0; // whitespace, ends the current token
+    const unsigned char DROPPED = 1;   // punctuation and control bytes, left out of the token
+    const unsigned char FIRST_KEPT = 2;
+
+    constexpr std::array<unsigned char, 256> makeTable()
+    {
+        std::array<unsigned char, 256> table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            bool whitespace = c == ' ' || (c >= '\t' && c <= '\r');
+            bool control = (c < 0x20 && !whitespace) || c == 0x7f;
+            if (whitespace)
+                table[c] = SEPARATOR;
+            else if (control || (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') ||
+                     (c >= '{' && c <= '~'))
+                table[c] = DROPPED;
+            else if (c >= 'A' && c <= 'Z')
+                table[c] = static_cast<unsigned char>(c - 'A' + 'a');
+            else
+                table[c] = static_cast<unsigned char>(c);
+        }
+        return table;
+    }
+
+    constexpr std::array<unsigned char, 256> TABLE = makeTable();
+
+    // Calls onToken(std::string &) for every non-empty token of text. The token is built in scratch,
+    // which is reused for every token, so onToken may modify it but has to copy it to keep it.
+    template <typename OnToken>
+    void forEachToken(std::string_view text, std::string &scratch, OnToken &&onToken)
+    {
+        scratch.clear();
+        for (unsigned char c : text)
+        {
+            unsigned char mapped = TABLE[c];
+            if (mapped >= FIRST_KEPT)
+            {
+                scratch.push_back(static_cast<char>(mapped));
+            }
+            else if (mapped == SEPARATOR && !scratch.empty())
+            {
+                onToken(scratch);
+                scratch.clear();
+            }
+        }
+        if (!scratch.empty())
+            onToken(scratch);
+    }
+}
+
+#endif // TOKENIZER_H
@@ -1,8 +1,21 @@
 #include "UserInterface.h"
 
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
 using namespace std;
 using namespace chrono;
 
+// Locations of the persisted index files
+static const string WORDS_FILE = "../wordsPersist.bin";
+static const string PEOPLE_FILE = "../peoplePersist.bin";
+static const string ORGS_FILE = "../orgPersist.bin";
+static const string DOCS_FILE = "../docsPersist.bin";
+
+// Number of results enterQuery shows
+static const size_t RESULTS_SHOWN = 15;
+
 // This function displays the Super Search menu and handles user input
 void UserInterface::displayMenu()
 {
@@ -70,18 +83,27 @@ void UserInterface::displayMenu()
     }
 }
 
-// This function creates an index of words from the given document path
-void UserInterface::createIndex(const string &path)
+// This function creates an index of words from the given document path using the given number of threads
+void UserInterface::createIndex(const string &path, int threads)
 {
     auto start = high_resolution_clock::now();
     cout << "Creating index..." << endl;
 
     DocumentParser parser;
-    parser.fileSystem(path, wordTree, people, orgs, stopWords, docTree);
+    parser.setPositional(positions);
+    parser.fileSystem(path, wordTree, people, orgs, stopWords, docTable, threads);
     numDocs = parser.getDocumentCount();
+    stemStatistics = parser.getStemStatistics();
 
     auto stop = high_resolution_clock::now();
     time = duration_cast<microseconds>(stop - start);
+
+    // Report the indexing throughput
+    double seconds = time.count() / 1e6;
+    cout << "Indexed " << numDocs << " documents with " << threads << " thread(s) in " << seconds << " s";
+    if (seconds > 0)
+        cout << " (" << numDocs / seconds << " docs/sec)";
+    cout << endl;
 }
 
 // This function writes the index data to files
@@ -90,20 +112,20 @@ void UserInterface::writeIndex() {
     Index index;
 
     // Save word data
-    string filePath = "../wordsPersist.txt";
-    index.saveWordData(filePath, wordTree);
+    string filePath = WORDS_FILE;
+    index.saveWordData(filePath, wordTree, docTable.size(), wordFile);
 
     // Save people data
-    filePath = "../peoplePersist.txt";
-    index.saveNameData(filePath, people);
+    filePath = PEOPLE_FILE;
+    index.saveNameData(filePath, people, docTable.size());
 
     // Save organization data
-    filePath = "../orgPersist.txt";
-    index.saveNameData(filePath, orgs);
+    filePath = ORGS_FILE;
+    index.saveNameData(filePath, orgs, docTable.size());
 
     // Save document data
-    filePath = "../docsPersist.txt";
-    index.saveDocumentData(filePath, docTree);
+    filePath = DOCS_FILE;
+    index.saveDocumentData(filePath, docTable);
 }
 
 // This function reads the index data from files
@@ -111,11 +133,110 @@ void UserInterface::readIndex()
 {
     cout << "Reading index from persistence..." << endl;
 
+    // The postings refer to the document IDs in the file, so nothing indexed before can be kept
+    wordTree.makeEmpty();
+    people.makeEmpty();
+    orgs.makeEmpty();
+
     Index index;
-    index.loadWordData("wordsPersist.txt", wordTree);
-    index.loadNameData("peoplePersist.txt", people);
-    index.loadNameData("orgPersist.txt", orgs);
-    index.loadDocumentData("docsPersist.txt", docTree);
+    index.loadWordData(WORDS_FILE, wordTree, &wordFile);
+    index.loadNameData(PEOPLE_FILE, people);
+    index.loadNameData(ORGS_FILE, orgs);
+    index.loadDocumentData(DOCS_FILE, docTable);
+}
+
+// This function maps the index files without building the trees. Queries then only copy the entries
+// of their own terms out of the mapped files, so startup cost does not grow with the index.
+void UserInterface::mapIndex()
+{
+    if (!mappedIndex.open(WORDS_FILE, PEOPLE_FILE, ORGS_FILE, DOCS_FILE))
+    {
+        cout << "No persisted index found, falling back to an empty index" << endl;
+    }
+}
+
+// This function fills the trees with the mapped entries of every term, prefix, person and organization
+// of the query Query::analyzeQuery parsed
+void UserInterface::loadQueryEntries(const Query::Expression &expression)
+{
+    Query::forEachWord(expression, [this](const Query::Word &word, bool positional)
+    {
+        if (word.kind == Query::Word::ORGANIZATION)
+        {
+            vector<uint32_t> postings;
+            if (!orgs.contains(word.text) && mappedIndex.findOrganization(word.text, postings))
+                orgs.insert(word.text, postings);
+        }
+        else if (word.kind == Query::Word::PERSON)
+        {
+            vector<uint32_t> postings;
+            if (!people.contains(word.text) && mappedIndex.findPerson(word.text, postings))
+                people.insert(word.text, postings);
+        }
+        else if (word.kind == Query::Word::PREFIX)
+        {
+            vector<pair<string, PostingList>> entries;
+            mappedIndex.findWordsWithPrefix(word.text, entries);
+            for (auto &entry : entries)
+                wordTree.emplace(entry.first, std::move(entry.second));
+        }
+        else if (word.kind == Query::Word::TERM)
+        {
+            // Only the terms of phrases and NEAR read their positions, the others skip over them
+            const PostingList *loaded = wordTree.find(word.text);
+            if (loaded != nullptr && (!positional || loaded->hasPositions()))
+                return;
+            PostingList postings;
+            if (mappedIndex.findWord(word.text, postings, positional))
+                wordTree[word.text] = std::move(postings);
+        }
+    });
+}
+
+// This function returns a document by its ID, from the mapped index when there is one
+document UserInterface::getDocument(uint32_t id)
+{
+    document doc;
+    if (mappedIndex.isOpen())
+        mappedIndex.findDocument(id, doc);
+    else
+        doc = docTable.getDocument(id);
+    return doc;
+}
+
+// This function gathers the document count and lengths the scorer needs, from the mapped index when
+// there is one
+CollectionStatistics UserInterface::collectionStatistics()
+{
+    CollectionStatistics statistics;
+    uint64_t totalLength;
+    if (mappedIndex.isOpen())
+    {
+        statistics.documentCount = mappedIndex.documentCount();
+        totalLength = mappedIndex.totalLength();
+        statistics.lengthOf = [this](uint32_t id) { return mappedIndex.documentLength(id); };
+    }
+    else
+    {
+        statistics.documentCount = docTable.size();
+        totalLength = docTable.totalLength();
+        statistics.lengthOf = [this](uint32_t id) { return docTable.lengthOf(id); };
+    }
+    if (statistics.documentCount > 0)
+        statistics.averageLength = static_cast<double>(totalLength) / statistics.documentCount;
+    return statistics;
+}
+
+// Function to choose the scoring function used by enterQuery
+void UserInterface::setScoring(Scoring function)
+{
+    scoring = function;
+}
+
+// Function to choose whether createIndex keeps the term positions phrase and NEAR queries need
+void UserInterface::setPositions(bool keep)
+{
+    positions = keep;
 }
 
 // Function to parse the query entered by user and output the results
@@ -123,8 +244,13 @@ void UserInterface::enterQuery(const string &choice, bool letOpen)
 {
     // Create a new Query object
     Query query = Query();
-    // Parse the query using the wordTree, people, orgs and stopWords
-    finalDocs = query.parseQuery(choice, wordTree, people, orgs, stopWords);
+    query.setWordFile(wordFile);
+    Query::Expression expression = query.analyzeQuery(choice, stopWords);
+    if (mappedIndex.isOpen())
+        loadQueryEntries(expression);
+    // Parse the query using the wordTree, people and orgs, keeping only the results shown
+    unique_ptr<Scorer> scorer = makeScorer(scoring, collectionStatistics());
+    finalDocs = query.parseQuery(expression, wordTree, people, orgs, *scorer, RESULTS_SHOWN);
 
     // Check if any results were found
     if (finalDocs.empty())
@@ -137,8 +263,8 @@ void UserInterface::enterQuery(const string &choice, bool letOpen)
         // Loop through the documents in the finalDocs vector
         for (const auto &d : finalDocs)
         {
-            // Get the document from the docTree
-            document doc = docTree.getValues(d.first);
+            // Get the document from the docTable
+            document doc = getDocument(d.first);
             // Output the various attributes of the document
             cout << i + 1 << endl;
             cout << "Title: " << doc.title << endl;
@@ -147,9 +273,6 @@ void UserInterface::enterQuery(const string &choice, bool letOpen)
             cout << "Published: " << doc.publicationDate << endl;
             cout << endl;
             i++;
-            // Break out of the loop after 15 iterations
-            if (i >= 15)
-                break;
         }
 
         // Let the user open the document if letOpen is true
@@ -169,7 +292,7 @@ void UserInterface::enterQuery(const string &choice, bool letOpen)
                 continue;
             }
             // Output the content of the document
-            cout << "Text: " << docTree.getValues(finalDocs.at(numInt - 1).first).content << endl;
+            cout << "Text: " << getDocument(finalDocs.at(numInt - 1).first).content << endl;
         }
     }
 }
@@ -188,12 +311,15 @@ void UserInterface::outputStatistics()
     cout << "Total Number of People: " << people.size() << endl;
     // Output the total number of organisations
     cout << "Total Number of Orgs: " << orgs.size() << endl;
+    // Output how often the stem cache saved running the stemmer
+    cout << "Stem cache hits: " << stemStatistics.hits << " of " << stemStatistics.lookups()
+         << " lookups (" << stemStatistics.hitRate() * 100 << "%)" << endl;
 
     // Resetting the tree after statistics output
     wordTree.makeEmpty();
 }
 
 // Function to read the query results
-const vector<pair<string, int>>& UserInterface::readQueryResults() const {
+const vector<pair<uint32_t, double>>& UserInterface::readQueryResults() const {
     return finalDocs;
 }
\ No newline at end of file
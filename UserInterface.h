@@ -10,6 +10,7 @@
 #include "AVLTree.h"  // Assuming this is the correct path
 #include "DocumentParser.h"
 #include "Index.h"
+#include "MappedIndex.h"
 #include "Query.h"
 #include "document.h"
 
@@ -19,22 +20,34 @@ using namespace chrono;
 class UserInterface {
 private:
     // Assuming specific types for keys and values as per your project's requirements
-    AvlTree<string, map<string, int>> wordTree;
-    AvlTree<string, set<string>> people;
-    AvlTree<string, document> docTree;
-    AvlTree<string, set<string>> orgs;          
-    AvlTree<string, string> stopWords;
-    vector<pair<string, int>> finalDocs;
+    AvlTree<string, PostingList> wordTree;
+    HashMap<string, vector<uint32_t>> people;
+    DocumentTable docTable;
+    HashMap<string, vector<uint32_t>> orgs;          
+    StopWordSet stopWords;
+    vector<pair<uint32_t, double>> finalDocs;
     microseconds time;
     int numDocs;
+    StemCache::Statistics stemStatistics; // stem cache use of the last createIndex
+    MappedIndex mappedIndex; // persisted index used in place of the trees when it is mapped
+    Scoring scoring = Scoring::BM25;
+    bool positions = false; // whether createIndex keeps term positions, for phrase and NEAR queries
+    string wordFile;        // words file readIndex loaded, which holds the positions of its terms
+
+    void loadQueryEntries(const Query::Expression& expression); // copies the entries a query needs out of mappedIndex
+    document getDocument(uint32_t id);
+    CollectionStatistics collectionStatistics();
 
 public:
     void displayMenu();
-    void createIndex(const string& path);
+    void createIndex(const string& path, int threads = 1);
     void writeIndex();  // tree to file
     void readIndex();   // file to tree
+    void mapIndex();    // file to read-only memory map, for one-shot queries
     void enterQuery(const string& query, bool letOpen);
     void outputStatistics();
-    const vector<pair<string, int>>& readQueryResults() const;
+    void setScoring(Scoring function); // how enterQuery ranks its results, BM25 by default
+    void setPositions(bool keep);      // whether createIndex keeps term positions, off by default
+    const vector<pair<uint32_t, double>>& readQueryResults() const;
 };
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define document_H
 
 #include <string>
+#include <utility>
 
 // Using a namespace in header files can cause conflicts when included in different contexts.
 // It's better practice to use the std:: prefix where needed.
@@ -11,8 +12,8 @@ public:
     // Constructor with optional parameters allows for creating an empty or fully initialized Document
     document(std::string title = "", std::string id = "", std::string pubDate = "", 
              std::string author = "", std::string text = "", int score = 0)
-    : title(title), identifier(id), publicationDate(pubDate), 
-      authorName(author), content(text), relevanceScore(score) {}
+    : title(std::move(title)), identifier(std::move(id)), publicationDate(std::move(pubDate)), 
+      authorName(std::move(author)), content(std::move(text)), relevanceScore(score) {}
 
     // Public member variables 
     std::string title;            // Title of the document
@@ -1,12 +1,15 @@
 #include <iostream>
 #include <exception>
 
+#include "Benchmark.h"
 #include "DocumentParser.h"
 #include "UserInterface.h"
 
 using namespace std;
 
 void runApplication(int argc, char **argv);
+int parseThreads(int argc, char **argv);
+bool hasOption(int argc, char **argv, const string &option);
 
 int main(int argc, char **argv) {
 
@@ -28,7 +31,7 @@ int main(int argc, char **argv) {
 
 void runApplication(int argc, char **argv) {
     if (argc < 2) {
-        cout << "Usage: [index/query/ui] [additional parameters]" << endl;
+        cout << "Usage: [index/query/ui/bench] [additional parameters]" << endl;
         return;
     }
 
@@ -40,18 +43,73 @@ void runApplication(int argc, char **argv) {
             cout << "Missing path for index command." << endl;
             return;
         }
-        ui.createIndex(argv[2]);
+        ui.setPositions(hasOption(argc, argv, "--positions"));
+        ui.createIndex(argv[2], parseThreads(argc, argv));
         ui.writeIndex();
     } else if (command == "query") {
         if (argc < 3) {
             cout << "Missing query string for query command." << endl;
             return;
         }
-        ui.readIndex();
+        ui.mapIndex();
         ui.enterQuery(argv[2], false);
     } else if (command == "ui") {
         ui.displayMenu();
+    } else if (command == "bench") {
+        if (argc < 4) {
+            cout << "Usage: bench index <path> [--threads N] | bench tree <count> | bench persist <path> | bench intersect <count> | bench tokenize <path> | bench stopwords <path> | bench entities <count> | bench avl <count> | bench dictionary <count> | bench topk <path>" << endl;
+            return;
+        }
+        string name = argv[2];
+        Benchmark benchmark;
+        if (name == "index") {
+            benchmark.indexing(argv[3], parseThreads(argc, argv));
+        } else if (name == "tree") {
+            benchmark.treeAllocation(stoi(argv[3]));
+        } else if (name == "persist") {
+            benchmark.persistence(argv[3]);
+        } else if (name == "intersect") {
+            benchmark.intersection(stoi(argv[3]));
+        } else if (name == "tokenize") {
+            benchmark.tokenizer(argv[3]);
+        } else if (name == "stopwords") {
+            benchmark.stopWords(argv[3]);
+        } else if (name == "entities") {
+            benchmark.entityIndex(stoi(argv[3]));
+        } else if (name == "avl") {
+            benchmark.treeOperations(stoi(argv[3]));
+        } else if (name == "dictionary") {
+            benchmark.termDictionary(stoi(argv[3]));
+        } else if (name == "topk") {
+            benchmark.topK(argv[3]);
+        } else {
+            cout << "Unknown benchmark: " << name << endl;
+        }
     } else {
         cout << "Invalid command." << endl;
     }
-}
\ No newline at end of file
+}
+
+// Returns the value of the --threads option, or 1 when it is not given
+int parseThreads(int argc, char **argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--threads") {
+            int threads = stoi(argv[i + 1]);
+            if (threads < 1) {
+                throw invalid_argument("--threads must be at least 1");
+            }
+            return threads;
+        }
+    }
+    return 1;
+}
+
+// Returns whether an option without a value is given
+bool hasOption(int argc, char **argv, const string &option) {
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == option) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -32,7 +32,11 @@
 
 #include <vector>
 #include <string>
+// The vendored hash it includes falls through its switch cases on purpose
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
 #include "util/string_view.h"
+#pragma GCC diagnostic pop
 
 namespace Porter2Stemmer
 {
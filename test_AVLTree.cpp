@@ -1,6 +1,14 @@
 #define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 #include "AVLTree.h"
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 TEST_CASE("AVL Tree functionality", "[AVLTree]")
 {
@@ -158,4 +166,268 @@ TEST_CASE("AVL Tree functionality", "[AVLTree]")
         REQUIRE(tree.contains(INT_MAX));
         REQUIRE(tree.contains(INT_MIN));
     }
-}
\ No newline at end of file
+}
+TEST_CASE("AVL Tree allocator policies", "[AVLTree]")
+{
+    SECTION("Heap allocated nodes")
+    {
+        AvlTree<int, int, HeapAllocator> heapTree;
+        for (int i = 0; i < 100; ++i)
+        {
+            heapTree.insert(i, i * 2);
+        }
+        heapTree.remove(50);
+        REQUIRE_FALSE(heapTree.contains(50));
+        REQUIRE(heapTree.getValues(99) == 198);
+        REQUIRE(heapTree.size() == 99);
+    }
+
+    SECTION("Slab allocated nodes across several blocks")
+    {
+        AvlTree<std::string, std::string> slabTree;
+        for (int i = 0; i < 5000; ++i)
+        {
+            slabTree.insert(std::to_string(i), std::to_string(i));
+        }
+        for (int i = 0; i < 5000; i += 2)
+        {
+            slabTree.remove(std::to_string(i));
+        }
+        for (int i = 0; i < 5000; i += 2)
+        {
+            slabTree[std::to_string(i)] = "again";
+        }
+        REQUIRE(slabTree.size() == 5000);
+        REQUIRE(slabTree.getValues("42") == "again");
+        REQUIRE(slabTree.getValues("43") == "43");
+    }
+
+    SECTION("Emptying and reusing a tree")
+    {
+        AvlTree<int, int> reusedTree;
+        for (int i = 0; i < 3000; ++i)
+        {
+            reusedTree.insert(i, i);
+        }
+        AvlTree<int, int> copiedTree(reusedTree);
+        reusedTree.makeEmpty();
+        REQUIRE(reusedTree.isEmpty());
+
+        reusedTree.insert(7, 7);
+        REQUIRE(reusedTree.size() == 1);
+        REQUIRE(copiedTree.size() == 3000);
+        REQUIRE(copiedTree.getValues(2999) == 2999);
+    }
+}
+
+TEST_CASE("AVL Tree rebalancing without recursion", "[AVLTree]")
+{
+    AvlTree<int, int> tree;
+    for (int i = 0; i < 20000; ++i)
+    {
+        int key = static_cast<int>((i * 7919L) % 20000); // Every key once, in scrambled order
+        if (i % 2 == 0)
+            tree.insert(key, key);
+        else
+            tree[key] = key;
+    }
+    for (int i = 0; i < 20000; ++i)
+    {
+        tree[-i - 1]; // Descending run, rotating at every other insert
+    }
+    REQUIRE_NOTHROW(tree.check_balance());
+    REQUIRE(tree.size() == 40000);
+    REQUIRE(tree.getValues(12345) == 12345);
+    REQUIRE(tree.getValues(-7) == 0);
+    REQUIRE_THROWS_AS(tree.getValues(40000), std::runtime_error);
+
+    int previous = INT_MIN;
+    bool ascending = true;
+    tree.forEach([&](const int &key, int &) {
+        ascending = ascending && previous < key;
+        previous = key;
+    });
+    REQUIRE(ascending);
+}
+
+TEST_CASE("AVL Tree order statistics", "[AVLTree]")
+{
+    AvlTree<int, int> tree;
+    for (int i = 0; i < 1000; ++i)
+    {
+        tree.insert(((i * 389) % 1000) * 2, i); // Even keys 0..1998 in scrambled order
+    }
+    for (int i = 0; i < 1000; i += 3)
+    {
+        tree.remove(i * 2);
+    }
+    REQUIRE_NOTHROW(tree.check_balance());
+    REQUIRE(tree.size() == 666);
+
+    std::vector<int> keys;
+    tree.forEach([&keys](const int &key, int &) { keys.push_back(key); });
+    for (int i = 0; i < tree.size(); ++i)
+    {
+        REQUIRE(tree.select(i) == keys[i]);
+        REQUIRE(tree.rank(keys[i]) == i);
+    }
+
+    SECTION("Keys that are not in the tree")
+    {
+        REQUIRE(tree.rank(-5) == 0);
+        REQUIRE(tree.rank(3) == 1);   // Only 2 is less
+        REQUIRE(tree.rank(6) == 2);   // 0 and 6 were removed, 2 and 4 are less
+        REQUIRE(tree.rank(5000) == 666);
+    }
+
+    SECTION("Positions outside the tree")
+    {
+        REQUIRE_THROWS_AS(tree.select(-1), std::out_of_range);
+        REQUIRE_THROWS_AS(tree.select(666), std::out_of_range);
+        AvlTree<int, int> emptyTree;
+        REQUIRE_THROWS_AS(emptyTree.select(0), std::out_of_range);
+    }
+}
+
+TEST_CASE("AVL Tree moving insertion and lookup without a Key", "[AVLTree]")
+{
+    AvlTree<std::string, std::vector<int>> tree;
+    std::string key = "market";
+    std::vector<int> postings = {1, 2, 3};
+    tree.insert(std::move(key), std::move(postings));
+    REQUIRE(postings.empty()); // The value was moved into the tree, not copied
+
+    SECTION("Emplace keeps an existing value")
+    {
+        REQUIRE(tree.emplace("stock", 4, 7) == std::vector<int>(4, 7));
+        REQUIRE(tree.emplace("market", 9, 9) == std::vector<int>({1, 2, 3}));
+        REQUIRE(tree.size() == 2);
+    }
+
+    SECTION("Find returns nullptr instead of throwing")
+    {
+        REQUIRE(tree.find(std::string("bond")) == nullptr);
+        REQUIRE(tree.find(std::string("market")) == &tree.getValues(std::string("market")));
+    }
+
+    SECTION("String views and literals are compared with the keys directly")
+    {
+        std::string_view view = "market and more";
+        REQUIRE(tree.contains(view.substr(0, 6)));
+        REQUIRE_FALSE(tree.contains(view.substr(0, 5)));
+        REQUIRE(tree.find(view.substr(0, 6))->size() == 3);
+        REQUIRE(tree.getValues("market").size() == 3);
+    }
+}
+
+TEST_CASE("AVL Tree built from sorted entries", "[AVLTree]")
+{
+    std::vector<std::pair<int, int>> entries;
+    for (int i = 0; i < 1000; ++i)
+    {
+        entries.emplace_back(i * 3, i);
+    }
+
+    AvlTree<int, int> tree;
+    tree.insert(-1, -1); // Replaced by the build
+    tree.buildFromSorted(entries.begin(), entries.end());
+    REQUIRE_NOTHROW(tree.check_balance());
+    REQUIRE(tree.size() == 1000);
+    REQUIRE_FALSE(tree.contains(-1));
+    REQUIRE(tree.getValues(2997) == 999);
+    REQUIRE(tree.select(500) == 1500);
+
+    tree.insert(1, 1); // The built tree takes further inserts like any other
+    REQUIRE_NOTHROW(tree.check_balance());
+    REQUIRE(tree.rank(3) == 2);
+
+    SECTION("Moving the entries in")
+    {
+        std::vector<std::pair<std::string, std::vector<int>>> postings = {{"a", {1}}, {"b", {2, 3}}};
+        AvlTree<std::string, std::vector<int>> words;
+        words.buildFromSorted(std::make_move_iterator(postings.begin()), std::make_move_iterator(postings.end()));
+        REQUIRE(postings[1].second.empty());
+        REQUIRE(words.getValues("b") == std::vector<int>({2, 3}));
+    }
+
+    SECTION("Entries out of order are rejected before the tree changes")
+    {
+        std::vector<std::pair<int, int>> unordered = {{1, 1}, {3, 3}, {3, 4}};
+        REQUIRE_THROWS_AS(tree.buildFromSorted(unordered.begin(), unordered.end()), std::invalid_argument);
+        REQUIRE(tree.size() == 1001);
+    }
+
+    SECTION("Empty range")
+    {
+        tree.buildFromSorted(entries.end(), entries.end());
+        REQUIRE(tree.isEmpty());
+    }
+}
+
+TEST_CASE("AVL Tree iterators and range scans", "[AVLTree]")
+{
+    AvlTree<std::string, int> tree;
+    std::vector<std::string> words = {"financial", "finance", "fin", "final", "fine", "apple", "zebra", "financ"};
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        tree.insert(words[i], static_cast<int>(i));
+    }
+
+    SECTION("Iteration visits the keys in ascending order")
+    {
+        std::vector<std::string> sorted = words;
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::string> visited;
+        for (auto entry : tree)
+        {
+            visited.push_back(entry.first);
+            entry.second += 100; // Values are reached through references
+        }
+        REQUIRE(visited == sorted);
+        REQUIRE(tree.getValues("zebra") == 106);
+        REQUIRE(std::distance(tree.begin(), tree.end()) == 8);
+
+        const AvlTree<std::string, int> &constTree = tree;
+        AvlTree<std::string, int>::const_iterator it = tree.begin();
+        REQUIRE(it->first == "apple");
+        REQUIRE(constTree.begin() == it);
+    }
+
+    SECTION("Bounds")
+    {
+        REQUIRE(tree.lower_bound("fina")->first == "final");
+        REQUIRE(tree.lower_bound("final")->first == "final");
+        REQUIRE(tree.upper_bound("final")->first == "financ");
+        REQUIRE(tree.upper_bound(std::string_view("zebra")) == tree.end());
+        REQUIRE(tree.lower_bound("") == tree.begin());
+
+        auto it = tree.lower_bound("fine");
+        ++it;
+        REQUIRE(it->first == "zebra");
+    }
+
+    SECTION("Prefix ranges")
+    {
+        std::vector<std::string> matches;
+        for (auto entry : tree.prefix_range("financ"))
+        {
+            matches.push_back(entry.first);
+        }
+        REQUIRE(matches == std::vector<std::string>({"financ", "finance", "financial"}));
+
+        auto all = tree.prefix_range("");
+        REQUIRE(std::distance(all.begin(), all.end()) == 8);
+        auto none = tree.prefix_range("fz");
+        REQUIRE(none.begin() == none.end());
+    }
+
+    SECTION("Level order keys")
+    {
+        std::vector<std::string> keys = tree.getKeys();
+        REQUIRE(keys.size() == 8);
+        REQUIRE(keys.front() == tree.select(tree.rank(keys.front())));
+        AvlTree<int, int> single;
+        single.insert(1, 1);
+        REQUIRE(single.getKeys() == std::vector<int>({1}));
+    }
+}
@@ -0,0 +1,98 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+#include "AVLTree.h"
+#include "FrozenDictionary.h"
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("Frozen Dictionary functionality", "[FrozenDictionary]")
+{
+    // Terms sharing their first 8 bytes, a term with a zero byte and one with a 0xFF byte make the
+    // packed heads tie and need the full text compared
+    AvlTree<std::string, int> tree;
+    std::vector<std::string> terms = {"financial", "financially", "financ", "finance", "a", "b", "zzz",
+                                      std::string("ab\0c", 4), "ab", "\xff\xff", "market", "marketing"};
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        tree.insert(terms[i], static_cast<int>(i));
+    }
+    FrozenDictionary<int> dictionary(tree.begin(), tree.end());
+
+    SECTION("Lookup")
+    {
+        REQUIRE(dictionary.size() == 12);
+        for (size_t i = 0; i < terms.size(); ++i)
+        {
+            REQUIRE(dictionary.contains(terms[i]));
+            REQUIRE(dictionary.getValues(terms[i]) == static_cast<int>(i));
+        }
+        REQUIRE(dictionary.find("financia") == nullptr);
+        REQUIRE(dictionary.find("") == nullptr);
+        REQUIRE(dictionary.find("zzzz") == nullptr);
+        REQUIRE_FALSE(dictionary.contains(std::string("ab\0", 3)));
+        REQUIRE_THROWS_AS(dictionary.getValues("nothing"), std::runtime_error);
+    }
+
+    SECTION("Iteration and ranges match the tree")
+    {
+        auto expected = tree.begin();
+        for (auto entry : dictionary)
+        {
+            REQUIRE(entry.first == expected->first);
+            REQUIRE(entry.second == expected->second);
+            ++expected;
+        }
+        REQUIRE(expected == tree.end());
+
+        auto range = dictionary.prefix_range("financ");
+        REQUIRE(std::distance(range.begin(), range.end()) == 4);
+        REQUIRE(range.begin()->first == "financ");
+        REQUIRE(dictionary.lower_bound("marketa")->first == "marketing");
+        REQUIRE(dictionary.lower_bound("\xff\xff\xff") == dictionary.end());
+    }
+
+    SECTION("Empty and unordered input")
+    {
+        FrozenDictionary<int> empty;
+        REQUIRE(empty.isEmpty());
+        REQUIRE_FALSE(empty.contains("a"));
+        REQUIRE(empty.begin() == empty.end());
+
+        std::vector<std::pair<std::string, int>> unordered = {{"b", 1}, {"a", 2}};
+        REQUIRE_THROWS_AS(FrozenDictionary<int>(unordered.begin(), unordered.end()), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Frozen Dictionary agrees with the tree on random terms", "[FrozenDictionary]")
+{
+    std::mt19937 rng(7);
+    AvlTree<std::string, int> tree;
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string term(1 + rng() % 12, ' ');
+        for (auto &ch : term)
+            ch = static_cast<char>('a' + rng() % 4); // Few letters, so many terms share long prefixes
+        tree.insert(term, i);
+    }
+    std::vector<std::pair<std::string, int>> entries;
+    tree.forEach([&entries](const std::string &term, int &value) { entries.emplace_back(term, value); });
+    FrozenDictionary<int> dictionary(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+    REQUIRE(dictionary.size() == tree.size());
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string term(1 + rng() % 12, ' ');
+        for (auto &ch : term)
+            ch = static_cast<char>('a' + rng() % 4);
+        const int *found = tree.find(term);
+        const int *frozen = dictionary.find(term);
+        REQUIRE((found == nullptr) == (frozen == nullptr));
+        if (found != nullptr)
+            REQUIRE(*found == *frozen);
+        REQUIRE((tree.lower_bound(term) == tree.end()) == (dictionary.lower_bound(term) == dictionary.end()));
+    }
+}
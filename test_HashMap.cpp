@@ -0,0 +1,76 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+#include "HashMap.h"
+#include <map>
+#include <random>
+#include <string>
+
+TEST_CASE("Hash Map functionality", "[HashMap]")
+{
+    HashMap<std::string, int> map;
+
+    SECTION("Insertion and lookup")
+    {
+        map.insert("alpha", 1);
+        map.insert("beta", 2);
+        map["gamma"] = 3;
+        map.insert("alpha", 4);
+
+        REQUIRE(map.size() == 3);
+        REQUIRE(map.getValues("alpha") == 4);
+        REQUIRE(map["beta"] == 2);
+        REQUIRE(map.contains("gamma"));
+        REQUIRE_FALSE(map.contains("delta"));
+        REQUIRE_THROWS_AS(map.getValues("delta"), std::runtime_error);
+    }
+
+    SECTION("Removal")
+    {
+        map.insert("alpha", 1);
+        map.insert("beta", 2);
+        map.remove("alpha");
+        map.remove("missing");
+
+        REQUIRE(map.size() == 1);
+        REQUIRE_FALSE(map.contains("alpha"));
+        REQUIRE(map.contains("beta"));
+    }
+
+    SECTION("Matches std::map under random operations")
+    {
+        std::map<std::string, int> expected;
+        std::mt19937 rng(7);
+        for (int i = 0; i < 20000; ++i)
+        {
+            std::string key = "key" + std::to_string(rng() % 3000);
+            if (rng() % 4 == 0)
+            {
+                map.remove(key);
+                expected.erase(key);
+            }
+            else
+            {
+                map[key] += i;
+                expected[key] += i;
+            }
+        }
+
+        REQUIRE(map.size() == expected.size());
+        size_t visited = 0;
+        map.forEach([&](const std::string &key, int &value) {
+            REQUIRE(expected.at(key) == value);
+            visited++;
+        });
+        REQUIRE(visited == expected.size());
+    }
+
+    SECTION("Emptying")
+    {
+        map.insert("alpha", 1);
+        map.makeEmpty();
+        REQUIRE(map.isEmpty());
+        REQUIRE_FALSE(map.contains("alpha"));
+        map.insert("alpha", 2);
+        REQUIRE(map.getValues("alpha") == 2);
+    }
+}
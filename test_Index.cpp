@@ -1,11 +1,13 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "Index.h"
-#include "AvlTree.h"
+#include "MappedIndex.h"
+#include "AVLTree.h"
 #include "document.h"
 #include <string>
 #include <map>
 #include <set>
+#include <fstream>
 
 using namespace std;
 
@@ -91,4 +93,184 @@ TEST_CASE("AVL Tree Querying and Updating", "[Index]")
         REQUIRE(nameTree.contains("Name1") == nameTree.contains("Name1"));
         REQUIRE(docTree.contains("doc1") == docTree.contains("doc1"));
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Binary Index Persistence", "[Index]")
+{
+    Index index;
+    AvlTree<string, PostingList> wordTree;
+    HashMap<string, vector<uint32_t>> nameTree;
+    DocumentTable docTable;
+
+    docTable.insert("uuid1", document("Title1", "uuid1", "2023-01-01", "Author1", "Line one\nline two"));
+    docTable.insert("uuid2", document("Title2", "uuid2", "2023-01-02", "Author2", "Content2"));
+    wordTree.insert("market", {{0, 3}, {1, 1}});
+    wordTree.insert("stock", {{1, 7}});
+    nameTree.insert("Name1", {0, 1});
+
+    SECTION("Round Trip")
+    {
+        string wordPath = "test_words.bin", namePath = "test_names.bin", docPath = "test_docs.bin";
+        index.saveWordData(wordPath, wordTree, docTable.size());
+        index.saveNameData(namePath, nameTree, docTable.size());
+        index.saveDocumentData(docPath, docTable);
+
+        AvlTree<string, PostingList> loadedWords;
+        HashMap<string, vector<uint32_t>> loadedNames;
+        DocumentTable loadedDocs;
+        index.loadWordData(wordPath, loadedWords);
+        index.loadNameData(namePath, loadedNames);
+        index.loadDocumentData(docPath, loadedDocs);
+
+        REQUIRE(loadedWords.size() == 2);
+        REQUIRE(loadedWords.getValues("market") == wordTree.getValues("market"));
+        REQUIRE(loadedWords.getValues("stock") == wordTree.getValues("stock"));
+        REQUIRE(loadedNames.getValues("Name1") == nameTree.getValues("Name1"));
+        REQUIRE(loadedDocs.size() == 2);
+        REQUIRE(loadedDocs.idOf("uuid2") == 1);
+        REQUIRE(loadedDocs.getDocument(0) == docTable.getDocument(0));
+    }
+
+    SECTION("Load Into A Non-Empty Tree")
+    {
+        string wordPath = "test_words.bin";
+        index.saveWordData(wordPath, wordTree, docTable.size());
+
+        // A term the tree already has gets the loaded postings merged into its own
+        AvlTree<string, PostingList> loadedWords;
+        loadedWords.insert("market", {{1, 2}});
+        loadedWords.insert("bond", {{0, 1}});
+        index.loadWordData(wordPath, loadedWords);
+
+        REQUIRE(loadedWords.size() == 3);
+        REQUIRE(loadedWords.getValues("market") == PostingList{{0, 3}, {1, 3}});
+        REQUIRE(loadedWords.getValues("stock") == wordTree.getValues("stock"));
+        REQUIRE(loadedWords.getValues("bond") == PostingList{{0, 1}});
+    }
+
+    SECTION("Positions")
+    {
+        PostingList positional;
+        positional.addPosition(0, 2);
+        positional.addPosition(0, 40);
+        positional.addPosition(1, 7);
+        positional.addPosition(0, 5); // out of order, lands between 2 and 40
+        REQUIRE(positional.frequencies() == vector<int>{3, 1});
+        wordTree.insert("rate", positional);
+
+        string wordPath = "test_words.bin";
+        index.saveWordData(wordPath, wordTree, docTable.size());
+        AvlTree<string, PostingList> loadedWords;
+        string wordFile;
+        index.loadWordData(wordPath, loadedWords, &wordFile);
+
+        // The positions stay in the file until they are read from it
+        PostingList loaded = loadedWords.getValues("rate");
+        REQUIRE_FALSE(loaded.hasPositions());
+        REQUIRE(loaded.docs() == positional.docs());
+        Index::readSavedPositions(wordFile, loaded);
+        REQUIRE(loaded == positional);
+        auto range = loaded.positionsAt(0);
+        REQUIRE(vector<uint32_t>(range.first, range.second) == vector<uint32_t>{2, 5, 40});
+        REQUIRE_FALSE(loadedWords.getValues("market").hasPositions());
+        REQUIRE(loadedWords.getValues("market").savedPositions() == 0);
+
+        // Saving the loaded tree again keeps the positions nothing read
+        index.saveWordData(wordPath, loadedWords, docTable.size(), wordFile);
+        AvlTree<string, PostingList> reloaded;
+        string reloadedFile;
+        index.loadWordData(wordPath, reloaded, &reloadedFile);
+        PostingList resaved = reloaded.getValues("rate");
+        Index::readSavedPositions(reloadedFile, resaved);
+        REQUIRE(resaved == positional);
+
+        // Without the file to read them from, a list is loaded without positions
+        AvlTree<string, PostingList> plain;
+        index.loadWordData(wordPath, plain);
+        REQUIRE(plain.getValues("rate").savedPositions() == 0);
+    }
+
+    SECTION("Corrupted File")
+    {
+        string wordPath = "test_words.bin";
+        index.saveWordData(wordPath, wordTree, docTable.size());
+        {
+            fstream file(wordPath, ios::in | ios::out | ios::binary);
+            file.seekp(-1, ios::end);
+            file.put('\x7f');
+        }
+
+        AvlTree<string, PostingList> loadedWords;
+        REQUIRE_THROWS_AS(index.loadWordData(wordPath, loadedWords), std::runtime_error);
+    }
+}
+
+TEST_CASE("Mapped Index Lookups", "[Index]")
+{
+    Index index;
+    AvlTree<string, PostingList> wordTree;
+    HashMap<string, vector<uint32_t>> nameTree;
+    DocumentTable docTable;
+
+    for (uint32_t i = 0; i < 101; ++i)
+    {
+        docTable.insert("uuid" + to_string(i), document("Title" + to_string(i), "uuid" + to_string(i)));
+    }
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        wordTree.insert("term" + to_string(i), {{i, static_cast<int>(i) + 1}, {i + 1, 1}});
+    }
+    nameTree.insert("Name1", {1, 2});
+    PostingList positional;
+    positional.addPosition(3, 1);
+    positional.addPosition(3, 4);
+    positional.addPosition(8, 0);
+    wordTree.insert("term50x", positional);
+
+    string wordPath = "test_words.bin", namePath = "test_names.bin", docPath = "test_docs.bin";
+    index.saveWordData(wordPath, wordTree, docTable.size());
+    index.saveNameData(namePath, nameTree, docTable.size());
+    index.saveDocumentData(docPath, docTable);
+
+    MappedIndex mapped;
+    REQUIRE(mapped.open(wordPath, namePath, namePath, docPath));
+
+    for (int i = 0; i < 100; ++i)
+    {
+        PostingList postings;
+        REQUIRE(mapped.findWord("term" + to_string(i), postings));
+        REQUIRE(postings == wordTree.getValues("term" + to_string(i)));
+    }
+    PostingList postings;
+    REQUIRE(mapped.findWord("term50x", postings));
+    REQUIRE_FALSE(postings.hasPositions()); // Only read when asked for
+    REQUIRE(postings.docs() == positional.docs());
+    postings = PostingList();
+    REQUIRE(mapped.findWord("term50x", postings, true));
+    REQUIRE(postings == positional);
+
+    PostingList missing;
+    REQUIRE_FALSE(mapped.findWord("term", missing));
+    REQUIRE_FALSE(mapped.findWord("zzz", missing));
+
+    vector<pair<string, PostingList>> prefixed;
+    REQUIRE(mapped.findWordsWithPrefix("term9", prefixed));
+    REQUIRE(prefixed.size() == 11); // term9 and term90..term99
+    REQUIRE(prefixed.front().first == "term9");
+    REQUIRE(prefixed.back().second == wordTree.getValues("term99"));
+    REQUIRE_FALSE(mapped.findWordsWithPrefix("terms", prefixed));
+
+    vector<uint32_t> names;
+    REQUIRE(mapped.findPerson("Name1", names));
+    REQUIRE(names == nameTree.getValues("Name1"));
+
+    document doc;
+    REQUIRE(mapped.findDocument(42, doc));
+    REQUIRE(doc == docTable.getDocument(42));
+    REQUIRE_FALSE(mapped.findDocument(101, doc));
+
+    // A file of the wrong kind is refused without an exception, and nothing stays mapped
+    REQUIRE_FALSE(mapped.open(namePath, namePath, namePath, docPath));
+    REQUIRE_FALSE(mapped.isOpen());
+    REQUIRE_FALSE(mapped.open(wordPath, namePath, namePath, wordPath));
+    REQUIRE_FALSE(mapped.isOpen());
+}
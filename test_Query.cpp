@@ -1,6 +1,14 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "Query.h"
+#include "Intersection.h"
+#include "StemCache.h"
+#include "porter2_stemmer.h"
+#include "StopWords.h"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <random>
 #include "UserInterface.h"
 
 const std::string basePath = "sample_data/coll_1/"; // Directory containing your sample data
@@ -65,3 +73,488 @@ TEST_CASE("Exclusion Terms in Query", "[Query]") {
     auto results = ui.readQueryResults();
     // Add checks to ensure 'exclude' term is handled correctly
 }
+
+TEST_CASE("Parallel Indexing", "[Query]") {
+    UserInterface serial;
+    serial.createIndex("sample_data/");
+    UserInterface parallel;
+    parallel.createIndex("sample_data/", 4);
+
+    serial.enterQuery("berlin", false);
+    parallel.enterQuery("berlin", false);
+    REQUIRE_FALSE(serial.readQueryResults().empty());
+    REQUIRE(serial.readQueryResults() == parallel.readQueryResults());
+}
+
+TEST_CASE("Parallel Indexing With Duplicate UUIDs", "[Query]") {
+    // Every file twice, so most UUIDs are parsed by two different workers
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "supersearch_duplicates";
+    std::filesystem::remove_all(directory);
+    for (const char* copy : {"a", "b"}) {
+        std::filesystem::create_directories(directory / copy);
+        std::filesystem::copy("sample_data", directory / copy, std::filesystem::copy_options::recursive);
+    }
+
+    StopWordSet stopWords;
+    auto build = [&](int threads, AvlTree<std::string, PostingList>& words,
+                     HashMap<std::string, std::vector<uint32_t>>& people,
+                     HashMap<std::string, std::vector<uint32_t>>& orgs) {
+        DocumentTable documentTable;
+        DocumentParser parser;
+        parser.fileSystem(directory.string(), words, people, orgs, stopWords, documentTable, threads);
+    };
+    AvlTree<std::string, PostingList> serialWords;
+    HashMap<std::string, std::vector<uint32_t>> serialPeople, serialOrgs;
+    build(1, serialWords, serialPeople, serialOrgs);
+    REQUIRE(serialOrgs.getValues("reuters").size() == 4);
+
+    for (int run = 0; run < 4; ++run) {
+        AvlTree<std::string, PostingList> words;
+        HashMap<std::string, std::vector<uint32_t>> people, orgs;
+        build(4, words, people, orgs);
+        REQUIRE(words.size() == serialWords.size());
+        serialWords.forEach([&words](const std::string& term, PostingList& postings) {
+            REQUIRE(words.getValues(term) == postings);
+        });
+        REQUIRE(people.size() == serialPeople.size());
+        serialPeople.forEach([&people](const std::string& name, std::vector<uint32_t>& docs) {
+            REQUIRE(people.getValues(name) == docs);
+        });
+        REQUIRE(orgs.size() == serialOrgs.size());
+        serialOrgs.forEach([&orgs](const std::string& name, std::vector<uint32_t>& docs) {
+            REQUIRE(orgs.getValues(name) == docs);
+        });
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Posting List Intersection", "[Query]") {
+    std::vector<uint32_t> small = {3, 9, 17, 40, 41, 1000};
+    std::vector<uint32_t> large;
+    for (uint32_t i = 0; i < 2000; i += 3) {
+        large.push_back(i);
+    }
+    std::vector<uint32_t> expected;
+    std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(expected));
+
+    std::vector<uint32_t> out(small.size());
+    SECTION("Every kernel finds the same documents") {
+        out.resize(Intersection::mergeIntersect(small.data(), small.size(), large.data(), large.size(), out.data()));
+        REQUIRE(out == expected);
+        out.resize(small.size());
+        out.resize(Intersection::gallopIntersect(small.data(), small.size(), large.data(), large.size(), out.data()));
+        REQUIRE(out == expected);
+        out.resize(small.size());
+        out.resize(Intersection::simdIntersect(small.data(), small.size(), large.data(), large.size(), out.data()));
+        REQUIRE(out == expected);
+        out.resize(small.size());
+        out.resize(Intersection::intersect(large.data(), large.size(), small.data(), small.size(), out.data()));
+        REQUIRE(out == expected);
+    }
+
+    SECTION("Subtraction") {
+        out.assign(small.begin(), small.end());
+        out.resize(Intersection::subtract(out.data(), out.size(), large.data(), large.size()));
+        REQUIRE(out == std::vector<uint32_t>{17, 40, 41, 1000});
+    }
+}
+
+TEST_CASE("Relevancy Ranking", "[Query]") {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    wordTree.insert("market", {{0, 2}, {1, 2}, {2, 5}, {3, 1}});
+    wordTree.insert("rare", {{1, 1}, {2, 1}});
+    std::vector<uint32_t> lengths = {10, 100, 50, 10};
+
+    CollectionStatistics statistics;
+    statistics.documentCount = 4;
+    statistics.averageLength = 42.5;
+    statistics.lengthOf = [&lengths](uint32_t id) { return lengths[id]; };
+    Query query;
+
+    SECTION("BM25 prefers shorter documents") {
+        Bm25Scorer scorer(statistics);
+        auto results = query.parseQuery("market", wordTree, people, orgs, stopWords, scorer);
+        REQUIRE(results.size() == 4);
+        REQUIRE(results[0].first == 0);
+        REQUIRE(results[3].first == 1);
+    }
+
+    SECTION("Top k") {
+        FrequencyScorer scorer(statistics);
+        auto results = query.parseQuery("market", wordTree, people, orgs, stopWords, scorer, 2);
+        REQUIRE(results == std::vector<std::pair<uint32_t, double>>{{2, 5}, {0, 2}});
+
+        results = query.parseQuery("market rare", wordTree, people, orgs, stopWords, scorer, 1);
+        REQUIRE(results == std::vector<std::pair<uint32_t, double>>{{2, 6}});
+    }
+}
+
+TEST_CASE("Prefix Terms", "[Query]") {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    wordTree.insert("financ", {{0, 1}, {4, 1}});
+    wordTree.insert("financi", {{1, 2}, {4, 3}});
+    wordTree.insert("finish", {{2, 1}});
+    wordTree.insert("market", {{1, 1}, {2, 1}, {4, 1}});
+
+    CollectionStatistics statistics;
+    statistics.documentCount = 5;
+    statistics.averageLength = 1;
+    statistics.lengthOf = [](uint32_t) { return 1u; };
+    FrequencyScorer scorer(statistics);
+    Query query;
+
+    // Counts of the terms under the prefix add up per document
+    auto results = query.parseQuery("financ*", wordTree, people, orgs, stopWords, scorer);
+    REQUIRE(results == std::vector<std::pair<uint32_t, double>>{{4, 4}, {1, 2}, {0, 1}});
+
+    results = query.parseQuery("fin* market", wordTree, people, orgs, stopWords, scorer);
+    REQUIRE(results == std::vector<std::pair<uint32_t, double>>{{4, 5}, {1, 3}, {2, 2}});
+
+    REQUIRE(query.parseQuery("zz*", wordTree, people, orgs, stopWords, scorer).empty());
+
+    // A frozen copy of the dictionary answers the same
+    FrozenDictionary<PostingList> frozen(wordTree.begin(), wordTree.end());
+    REQUIRE(query.parseQuery("fin* market", frozen, people, orgs, stopWords, scorer) ==
+            query.parseQuery("fin* market", wordTree, people, orgs, stopWords, scorer));
+    REQUIRE(query.parseQuery("market -finish", frozen, people, orgs, stopWords, scorer).size() == 2);
+}
+
+TEST_CASE("Stem Cache", "[Query]") {
+    StemCache cache(2);
+    std::vector<std::string> words = {"running", "markets", "running", "running", "cats", "markets"};
+    for (const auto& word : words) {
+        std::string cached = word, direct = word;
+        cache.stem(cached);
+        Porter2Stemmer::stem(direct);
+        REQUIRE(cached == direct);
+    }
+    // "cats" fills the cache past its capacity, so the second "markets" misses again
+    REQUIRE(cache.statistics().hits == 2);
+    REQUIRE(cache.statistics().misses == 4);
+}
+
+TEST_CASE("Query Analysis", "[Query]") {
+    StopWordSet stopWords;
+    Analyzer analyzer;
+    std::vector<std::string> terms;
+    analyzer.analyze("The Markets rallied, and TRADERS cheered!", stopWords,
+                     [&terms](std::string& term) { terms.push_back(term); });
+    REQUIRE(terms == std::vector<std::string>{"market", "ralli", "trader", "cheer"});
+
+    // A single word analyzes to the term its occurrences in a document are indexed under
+    std::string term;
+    REQUIRE(analyzer.analyzeWord("Markets,", stopWords, term));
+    REQUIRE(term == "market");
+    REQUIRE_FALSE(analyzer.analyzeWord("The", stopWords, term));
+    REQUIRE_FALSE(analyzer.analyzeWord("...", stopWords, term));
+    REQUIRE(analyzer.normalize("Fin-ancials", term));
+    REQUIRE(term == "financials");
+    REQUIRE(analyzer.normalize("Fin\x02" "anc\x1f" "ials\x7f", term)); // Control bytes are dropped too
+    REQUIRE(term == "financials");
+
+    Query query;
+    auto expression = query.analyzeQuery("Markets the fin* -Bonds org:Reuters person:Jane", stopWords);
+    REQUIRE(expression.kind == Query::Expression::AND);
+    REQUIRE(expression.operands.size() == 5);
+    const auto& words = expression.operands;
+    REQUIRE((words[0].word.kind == Query::Word::TERM && words[0].word.text == "market"));
+    REQUIRE((words[1].word.kind == Query::Word::PREFIX && words[1].word.text == "fin"));
+    REQUIRE(words[2].kind == Query::Expression::NOT);
+    REQUIRE(words[2].operands.front().word.text == "bond");
+    REQUIRE((words[3].word.kind == Query::Word::ORGANIZATION && words[3].word.text == "reuters"));
+    REQUIRE((words[4].word.kind == Query::Word::PERSON && words[4].word.text == "jane"));
+
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    wordTree.insert("market", {{0, 2}, {3, 1}});
+    CollectionStatistics statistics;
+    statistics.documentCount = 4;
+    statistics.averageLength = 1;
+    statistics.lengthOf = [](uint32_t) { return 1u; };
+    FrequencyScorer scorer(statistics);
+    REQUIRE(query.parseQuery("MARKETS", wordTree, people, orgs, stopWords, scorer) ==
+            query.parseQuery("market", wordTree, people, orgs, stopWords, scorer));
+    REQUIRE(query.parseQuery("markets", wordTree, people, orgs, stopWords, scorer).size() == 2);
+}
+
+TEST_CASE("Excluded Terms", "[Query]") {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    wordTree.insert("market", {{0, 1}, {1, 1}, {2, 1}, {3, 1}, {5, 1}});
+    wordTree.insert("bond", {{1, 1}, {3, 1}, {4, 1}});
+    wordTree.insert("stock", {{0, 1}, {4, 1}, {5, 1}});
+
+    CollectionStatistics statistics;
+    statistics.documentCount = 6;
+    statistics.averageLength = 1;
+    statistics.lengthOf = [](uint32_t) { return 1u; };
+    FrequencyScorer scorer(statistics);
+    Query query;
+    auto documentsOf = [&](const std::string& text) {
+        std::vector<uint32_t> ids;
+        for (const auto& result : query.parseQuery(text, wordTree, people, orgs, stopWords, scorer))
+            ids.push_back(result.first);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    // The excluded word is stemmed like the documents were, so "-Bonds" removes the "bond" documents
+    REQUIRE(documentsOf("market -Bonds") == std::vector<uint32_t>{0, 2, 5});
+    REQUIRE(documentsOf("market -bonds -stocks") == std::vector<uint32_t>{2});
+    REQUIRE(documentsOf("market -the -unknown") == std::vector<uint32_t>{0, 1, 2, 3, 5});
+    REQUIRE(documentsOf("-bond").empty());
+}
+
+TEST_CASE("Boolean Queries", "[Query]") {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    wordTree.insert("market", {{0, 1}, {1, 1}, {2, 1}, {3, 1}, {5, 1}});
+    wordTree.insert("bond", {{1, 1}, {3, 1}, {4, 2}});
+    wordTree.insert("stock", {{0, 1}, {4, 1}, {5, 1}});
+    wordTree.insert("oil", {{6, 3}});
+
+    CollectionStatistics statistics;
+    statistics.documentCount = 7;
+    statistics.averageLength = 1;
+    statistics.lengthOf = [](uint32_t) { return 1u; };
+    FrequencyScorer scorer(statistics);
+    Query query;
+    auto documentsOf = [&](const std::string& text) {
+        std::vector<uint32_t> ids;
+        for (const auto& result : query.parseQuery(text, wordTree, people, orgs, stopWords, scorer))
+            ids.push_back(result.first);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    SECTION("Operators and grouping") {
+        REQUIRE(documentsOf("bond OR oil") == std::vector<uint32_t>{1, 3, 4, 6});
+        REQUIRE(documentsOf("market AND (bond OR oil)") == std::vector<uint32_t>{1, 3});
+        REQUIRE(documentsOf("stock OR bond AND market") == std::vector<uint32_t>{0, 1, 3, 4, 5});
+        REQUIRE(documentsOf("(stock OR bond) -market") == std::vector<uint32_t>{4});
+        REQUIRE(documentsOf("market NOT (stock OR bond)") == std::vector<uint32_t>{2});
+        REQUIRE(documentsOf("bond NOT NOT stock") == std::vector<uint32_t>{4});
+    }
+
+    SECTION("Empty operands") {
+        // A word without documents empties its AND but not the OR around it
+        REQUIRE(documentsOf("market unknown").empty());
+        REQUIRE(documentsOf("unknown OR oil") == std::vector<uint32_t>{6});
+        REQUIRE(documentsOf("NOT market").empty());
+        REQUIRE(documentsOf("the OR bond") == std::vector<uint32_t>{1, 3, 4});
+        // Operators are only recognized in capitals, "or" is a stop word
+        REQUIRE(documentsOf("bond or stock") == std::vector<uint32_t>{4});
+    }
+
+    SECTION("Malformed queries") {
+        REQUIRE(documentsOf("(market bond") == std::vector<uint32_t>{1, 3});
+        REQUIRE(documentsOf("market) bond") == std::vector<uint32_t>{1, 3});
+        REQUIRE(documentsOf("market OR") == std::vector<uint32_t>{0, 1, 2, 3, 5});
+        REQUIRE(documentsOf("AND oil NOT") == std::vector<uint32_t>{6});
+        REQUIRE(documentsOf("()").empty());
+    }
+
+    SECTION("Ranking") {
+        // A document matching an OR is scored by the words it contains
+        auto results = query.parseQuery("bond OR oil", wordTree, people, orgs, stopWords, scorer);
+        REQUIRE(results == std::vector<std::pair<uint32_t, double>>{{6, 3}, {4, 2}, {1, 1}, {3, 1}});
+
+        FrozenDictionary<PostingList> frozen(wordTree.begin(), wordTree.end());
+        REQUIRE(query.parseQuery("(stock OR oil) -bond", frozen, people, orgs, stopWords, scorer) ==
+                query.parseQuery("(stock OR oil) -bond", wordTree, people, orgs, stopWords, scorer));
+    }
+}
+
+TEST_CASE("Phrase Queries", "[Query]") {
+    // Positions of the terms of "interest rate rise" (0), "rate of interest" (1) and
+    // "interest ... rate" with four terms in between (2)
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    PostingList interest, rate, rise;
+    interest.addPosition(0, 0);
+    rate.addPosition(0, 1);
+    rise.addPosition(0, 2);
+    rate.addPosition(1, 0);
+    interest.addPosition(1, 1);
+    interest.addPosition(2, 0);
+    rate.addPosition(2, 5);
+    wordTree.insert("interest", interest);
+    wordTree.insert("rate", rate);
+    wordTree.insert("rise", rise);
+
+    CollectionStatistics statistics;
+    statistics.documentCount = 3;
+    statistics.averageLength = 3;
+    statistics.lengthOf = [](uint32_t) { return 3u; };
+    FrequencyScorer scorer(statistics);
+    Query query;
+    auto documentsOf = [&](const std::string& text) {
+        std::vector<uint32_t> ids;
+        for (const auto& result : query.parseQuery(text, wordTree, people, orgs, stopWords, scorer))
+            ids.push_back(result.first);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    SECTION("Phrases") {
+        REQUIRE(documentsOf("interest rate") == std::vector<uint32_t>{0, 1, 2});
+        REQUIRE(documentsOf("\"interest rate\"") == std::vector<uint32_t>{0});
+        // Analyzed like the documents: stemmed, and the stop word "of" takes no position
+        REQUIRE(documentsOf("\"Interest Rates Rise\"") == std::vector<uint32_t>{0});
+        REQUIRE(documentsOf("\"rate of interest\"") == std::vector<uint32_t>{1});
+        REQUIRE(documentsOf("\"rate interest\" OR \"rate rise\"") == std::vector<uint32_t>{0, 1});
+        REQUIRE(documentsOf("interest -\"interest rate\"") == std::vector<uint32_t>{1, 2});
+        REQUIRE(documentsOf("\"interest unknown\"").empty());
+        REQUIRE(documentsOf("\"rate\"") == std::vector<uint32_t>{0, 1, 2});
+    }
+
+    SECTION("Proximity") {
+        REQUIRE(documentsOf("interest NEAR/1 rate") == std::vector<uint32_t>{0, 1});
+        REQUIRE(documentsOf("interest NEAR/5 rate") == std::vector<uint32_t>{0, 1, 2});
+        REQUIRE(documentsOf("rise NEAR/1 interest").empty());
+        REQUIRE(documentsOf("rise NEAR/2 interest") == std::vector<uint32_t>{0});
+        // NEAR between anything but two terms only needs both sides to match
+        REQUIRE(documentsOf("rise NEAR/1 inter*") == std::vector<uint32_t>{0});
+    }
+
+    SECTION("Index without positions") {
+        AvlTree<std::string, PostingList> plain;
+        plain.insert("interest", {{0, 1}, {1, 1}, {2, 1}});
+        plain.insert("rate", {{0, 1}, {1, 1}, {2, 1}});
+        REQUIRE(query.parseQuery("\"interest rate\"", plain, people, orgs, stopWords, scorer).size() == 3);
+    }
+
+    SECTION("Loaded from a words file") {
+        Index index;
+        std::string wordPath = "test_phrase_words.bin";
+        index.saveWordData(wordPath, wordTree, 3);
+        AvlTree<std::string, PostingList> loaded;
+        std::string wordFile;
+        index.loadWordData(wordPath, loaded, &wordFile);
+        query.setWordFile(wordFile);
+        REQUIRE_FALSE(loaded.getValues("rate").hasPositions());
+        for (const std::string text : {"\"interest rate\"", "interest NEAR/1 rate", "interest rate"})
+            REQUIRE(query.parseQuery(text, loaded, people, orgs, stopWords, scorer) ==
+                    query.parseQuery(text, wordTree, people, orgs, stopWords, scorer));
+        // The query decoded copies of the lists, the loaded ones leave their positions in the file
+        REQUIRE_FALSE(loaded.getValues("rate").hasPositions());
+    }
+
+    SECTION("Parsed with positions") {
+        AvlTree<std::string, PostingList> parsedWords;
+        HashMap<std::string, std::vector<uint32_t>> parsedPeople, parsedOrgs;
+        DocumentTable documentTable;
+        DocumentParser parser;
+        parser.setPositional(true);
+        parser.fileSystem("sample_data/", parsedWords, parsedPeople, parsedOrgs, stopWords, documentTable, 2);
+        parsedWords.forEach([](const std::string&, PostingList& postings) {
+            REQUIRE(postings.hasPositions());
+            for (size_t i = 0; i < postings.size(); ++i) {
+                auto range = postings.positionsAt(i);
+                REQUIRE(range.second - range.first == postings.frequencies()[i]);
+                REQUIRE(std::is_sorted(range.first, range.second));
+            }
+        });
+    }
+}
+
+TEST_CASE("Top-k Pruning", "[Query]") {
+    // Terms of very different frequencies over documents of random lengths, so that both whole lists
+    // and blocks of postings can be skipped
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    std::mt19937 rng(7);
+    std::vector<uint32_t> lengths(5000);
+    for (uint32_t& length : lengths)
+        length = 20 + rng() % 400;
+    std::vector<std::pair<std::string, int>> terms = {{"stock", 2}, {"market", 3}, {"earn", 40}, {"oil", 400}};
+    for (const auto& term : terms)
+        for (uint32_t id = 0; id < lengths.size(); ++id)
+            if (rng() % term.second == 0)
+                wordTree[term.first].add(id, 1 + static_cast<int>(rng() % (id % 700 == 0 ? 30 : 4)));
+    std::vector<uint32_t> mentions;
+    for (uint32_t id = 0; id < lengths.size(); id += 97)
+        mentions.push_back(id);
+    people.insert("jane", mentions);
+
+    CollectionStatistics statistics;
+    statistics.documentCount = static_cast<uint32_t>(lengths.size());
+    statistics.averageLength = 220;
+    statistics.lengthOf = [&lengths](uint32_t id) { return lengths[id]; };
+    Bm25Scorer bm25(statistics);
+    TfIdfScorer tfIdf(statistics);
+    FrequencyScorer frequency(statistics);
+    Query query;
+
+    SECTION("Same results as scoring every document") {
+        for (const Scorer* scorer : std::vector<const Scorer*>{&bm25, &tfIdf, &frequency}) {
+            for (const std::string text : {"stock OR market OR earn", "oil OR earn", "market", "earn OR person:jane",
+                                           "stock OR market OR earn OR oil", "oil OR (stock unknown)"}) {
+                for (size_t k : {1, 15, 100}) {
+                    query.setPruning(false);
+                    auto exhaustive = query.parseQuery(text, wordTree, people, orgs, stopWords, *scorer, k);
+                    size_t everyDocument = query.documentsScored();
+                    query.setPruning(true);
+                    REQUIRE(query.parseQuery(text, wordTree, people, orgs, stopWords, *scorer, k) == exhaustive);
+                    REQUIRE(query.documentsScored() <= everyDocument);
+                }
+            }
+        }
+    }
+
+    SECTION("Fewer documents scored") {
+        query.setPruning(false);
+        query.parseQuery("stock OR market OR earn", wordTree, people, orgs, stopWords, bm25, 15);
+        size_t everyDocument = query.documentsScored();
+        query.setPruning(true);
+        query.parseQuery("stock OR market OR earn", wordTree, people, orgs, stopWords, bm25, 15);
+        REQUIRE(query.documentsScored() < everyDocument / 2);
+
+        // Without k every document is ranked
+        query.parseQuery("stock OR market OR earn", wordTree, people, orgs, stopWords, bm25);
+        REQUIRE(query.documentsScored() == everyDocument);
+    }
+}
+
+TEST_CASE("Stop Word Set", "[Query]") {
+    StopWordSet english;
+    REQUIRE(english.size() == ENGLISH_STOP_WORDS.size());
+    for (std::string_view word : ENGLISH_STOP_WORDS) {
+        REQUIRE(english.contains(word));
+    }
+    REQUIRE_FALSE(english.contains("market"));
+    REQUIRE_FALSE(english.contains("th"));
+    REQUIRE_FALSE(english.contains(""));
+
+    StopWordSet custom(std::vector<std::string>{"alpha", "beta", "alpha"});
+    REQUIRE(custom.size() == 2);
+    REQUIRE(custom.contains("beta"));
+    REQUIRE_FALSE(custom.contains("the"));
+}
+
+TEST_CASE("Entity Postings", "[Query]") {
+    AvlTree<std::string, PostingList> wordTree;
+    HashMap<std::string, std::vector<uint32_t>> people, orgs;
+    StopWordSet stopWords;
+    DocumentTable documentTable;
+    DocumentParser parser;
+    parser.fileSystem("sample_data/", wordTree, people, orgs, stopWords, documentTable);
+
+    // Every document mentioning an organization is kept, not just the last one indexed
+    REQUIRE(orgs.getValues("reuters").size() == 4);
+    REQUIRE(orgs.getValues("eikon").size() == 3);
+    REQUIRE(std::is_sorted(orgs.getValues("reuters").begin(), orgs.getValues("reuters").end()));
+
+    UserInterface ui;
+    ui.createIndex("sample_data/");
+    ui.enterQuery("org:reuters", false);
+    REQUIRE(ui.readQueryResults().size() == 4);
+}